@@ -0,0 +1,150 @@
+// watson-bench-generation: time create_game_with_clues on every board size
+//
+// usage: watson-bench-generation [-n count] [-t threads] [-b] [-a]
+//
+// count puzzles (default 20) are generated from fixed seeds for every size from 4x4 to 8x8, basic and advanced.
+// the report gives the mean and the p50 / p95 / p99 / max generation time in ms, and how the time splits between
+// sampling clues, check_clues, filter_clues and record_script.
+
+#include "game_data.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+static auto percentile( const std::vector<double> &sorted, double p ) -> double
+{
+    // nearest rank
+    size_t rank = size_t( p / 100.0 * sorted.size() + 0.999999 );
+    return sorted[std::min( std::max( rank, size_t( 1 ) ), sorted.size() ) - 1];
+}
+
+static void usage()
+{
+    fprintf( stderr, "usage: watson-bench-generation [-n count] [-t threads] [-b] [-a]\n" );
+    fprintf( stderr, "  -n count   puzzles for every size and mode (default 20)\n" );
+    fprintf( stderr, "  -t threads worker threads for the \"what if\" probes (default: every core)\n" );
+    fprintf( stderr, "  -b         only basic puzzles\n" );
+    fprintf( stderr, "  -a         only advanced puzzles\n" );
+}
+
+auto main( int argc, char **argv ) -> int
+{
+    int count = 20;
+    int threads = 0;
+    int first_mode = 0;
+    int last_mode = 1;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strcmp( argv[i], "-b" ) )
+        {
+            last_mode = 0;
+        }
+        else if( !strcmp( argv[i], "-a" ) )
+        {
+            first_mode = 1;
+        }
+        else if( !strcmp( argv[i], "-n" ) && i + 1 < argc )
+        {
+            count = atoi( argv[++i] );
+        }
+        else if( !strcmp( argv[i], "-t" ) && i + 1 < argc )
+        {
+            threads = atoi( argv[++i] );
+        }
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if( count < 1 || first_mode > last_mode )
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    spdlog::set_level( spdlog::level::warn );
+    reset_rel_params();
+
+    printf( "%-5s %-8s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+            "size",
+            "mode",
+            "mean ms",
+            "p50 ms",
+            "p95 ms",
+            "p99 ms",
+            "max ms",
+            "sampling",
+            "check",
+            "filter",
+            "script" );
+
+    for( int advanced = first_mode; advanced <= last_mode; advanced++ )
+    {
+        for( int number_of_columns = 4; number_of_columns <= 8; number_of_columns++ )
+        {
+            for( int column_height = 4; column_height <= 8; column_height++ )
+            {
+                GameData game_data = {};
+                game_data.number_of_columns = number_of_columns;
+                game_data.column_height = column_height;
+                game_data.advanced = advanced;
+                game_data.threads = threads;
+
+                std::vector<double> ms;
+                GenerationTimes total = {};
+                for( int i = 0; i < count; i++ )
+                {
+                    game_data.rng.seed( 100000 * number_of_columns + 1000 * column_height + i );
+
+                    auto start = std::chrono::steady_clock::now();
+                    game_data.create_game_with_clues();
+                    auto stop = std::chrono::steady_clock::now();
+
+                    ms.push_back( std::chrono::duration<double, std::milli>( stop - start ).count() );
+                    total.sampling += game_data.generation_times.sampling;
+                    total.check += game_data.generation_times.check;
+                    total.filter += game_data.generation_times.filter;
+                    total.script += game_data.generation_times.script;
+                }
+
+                std::sort( ms.begin(), ms.end() );
+                double mean = 0;
+                for( double t : ms )
+                {
+                    mean += t;
+                }
+                mean /= ms.size();
+                double steps = total.sampling + total.check + total.filter + total.script;
+                if( steps <= 0 )
+                {
+                    steps = 1;
+                }
+
+                printf( "%dx%-3d %-8s %9.2f %9.2f %9.2f %9.2f %9.2f %8.1f%% %8.1f%% %8.1f%% %8.1f%%\n",
+                        number_of_columns,
+                        column_height,
+                        advanced ? "advanced" : "basic",
+                        mean,
+                        percentile( ms, 50 ),
+                        percentile( ms, 95 ),
+                        percentile( ms, 99 ),
+                        ms.back(),
+                        100.0 * total.sampling / steps,
+                        100.0 * total.check / steps,
+                        100.0 * total.filter / steps,
+                        100.0 * total.script / steps );
+                fflush( stdout );
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
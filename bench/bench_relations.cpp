@@ -0,0 +1,304 @@
+// watson-bench-relations: time the clue kernels of every relation
+//
+// usage: watson-bench-relations [-m min_ms] [-o results] [-b baseline]
+//
+// the corpus is made of mid-game boards from 4x4 to 8x8: puzzles generated from fixed seeds, with half of their
+// clues applied. for every relation, clues that hold in the solution are generated on each board, and
+// check_this_clue_* (with push_level / pop_level to undo its changes, minus the cost of an empty level) and
+// is_clue_compatible_* are timed over all of them.
+// -o saves the ns/op of each relation, -b compares the run against a file saved with -o.
+
+#include "game_data.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+constexpr int BOARDS_PER_SIZE = 16;
+constexpr int CLUES_PER_BOARD = 16;
+
+const char *relation_name[NUMBER_OF_RELATIONS] = { "NEXT_TO",
+                                                   "NOT_NEXT_TO",
+                                                   "ONE_SIDE",
+                                                   "CONSECUTIVE",
+                                                   "NOT_MIDDLE",
+                                                   "TOGETHER_2",
+                                                   "TOGETHER_3",
+                                                   "NOT_TOGETHER",
+                                                   "TOGETHER_NOT_MIDDLE",
+                                                   "TOGETHER_FIRST_WITH_ONLY_ONE",
+                                                   "REVEAL" };
+
+using CheckKernel = auto ( GameData::* )( PackedClue clue ) -> TileAddress;
+using CompatibleKernel = auto ( GameData::* )( PackedClue clue ) -> int;
+using ClueMaker = void ( GameData::* )( int column, int row, int cell, Clue *clue );
+
+const CheckKernel check_kernel[NUMBER_OF_RELATIONS] = { &GameData::check_this_clue_next_to,
+                                                        &GameData::check_this_clue_not_next_to,
+                                                        &GameData::check_this_clue_one_side,
+                                                        &GameData::check_this_clue_consecutive,
+                                                        &GameData::check_this_clue_not_middle,
+                                                        &GameData::check_this_clue_together_2,
+                                                        &GameData::check_this_clue_together_3,
+                                                        &GameData::check_this_clue_not_together,
+                                                        &GameData::check_this_clue_together_not_middle,
+                                                        &GameData::check_this_clue_together_first_with_only_one,
+                                                        &GameData::check_this_clue_reveal };
+
+const CompatibleKernel compatible_kernel[NUMBER_OF_RELATIONS] = {
+    &GameData::is_clue_compatible_next_to,
+    &GameData::is_clue_compatible_not_next_to,
+    &GameData::is_clue_compatible_one_side,
+    &GameData::is_clue_compatible_consecutive,
+    &GameData::is_clue_compatible_not_middle,
+    &GameData::is_clue_compatible_together_2,
+    &GameData::is_clue_compatible_together_3,
+    &GameData::is_clue_compatible_not_together,
+    &GameData::is_clue_compatible_together_not_middle,
+    &GameData::is_clue_compatible_together_first_with_only_one,
+    &GameData::is_clue_compatible_reveal };
+
+const ClueMaker clue_maker[NUMBER_OF_RELATIONS] = { &GameData::get_clue_next_to,
+                                                    &GameData::get_clue_not_next_to,
+                                                    &GameData::get_clue_one_side,
+                                                    &GameData::get_clue_consecutive,
+                                                    &GameData::get_clue_not_middle,
+                                                    &GameData::get_clue_together_2,
+                                                    &GameData::get_clue_together_3,
+                                                    &GameData::get_clue_not_together,
+                                                    &GameData::get_clue_together_not_middle,
+                                                    &GameData::get_clue_together_first_with_only_one,
+                                                    &GameData::get_clue_reveal };
+
+struct Sample
+{
+    GameData *board;
+    PackedClue clue;
+};
+
+struct Result
+{
+    double check_ns;
+    double compatible_ns;
+};
+
+volatile int sink;
+
+static auto make_board( int number_of_columns, int column_height, uint64_t seed ) -> GameData *
+{
+    auto *board = new GameData();
+    board->number_of_columns = number_of_columns;
+    board->column_height = column_height;
+    board->threads = 1;
+    board->rng.seed( seed );
+    board->create_game_with_clues();
+
+    // mid-game: only the first half of the clues has been used
+    ClueList clues = board->clues;
+    board->clues.resize( clues.size() / 2 );
+    board->check_clues();
+    board->clues = clues;
+    return board;
+}
+
+static auto make_samples( std::vector<GameData *> &boards, int rel ) -> std::vector<Sample>
+{
+    std::vector<Sample> samples;
+    for( auto *board : boards )
+    {
+        for( int i = 0; i < CLUES_PER_BOARD; i++ )
+        {
+            int column = board->rand_int( board->number_of_columns );
+            int row = board->rand_int( board->column_height );
+            Clue clue;
+            clue.rel = (RELATION)rel;
+            ( board->*clue_maker[rel] )( column, row, board->puzzle[column][row], &clue );
+            samples.push_back( { board, PackedClue( clue ) } );
+        }
+    }
+    return samples;
+}
+
+template<typename F>
+static auto time_ns( int min_ms, size_t ops_per_run, F run ) -> double
+{
+    using clock = std::chrono::steady_clock;
+
+    size_t runs = 0;
+    auto start = clock::now();
+    auto stop = start + std::chrono::milliseconds( min_ms );
+    auto now = start;
+    do
+    {
+        run();
+        runs++;
+        now = clock::now();
+    } while( now < stop );
+
+    return std::chrono::duration<double, std::nano>( now - start ).count() / double( runs * ops_per_run );
+}
+
+static auto bench_relation( std::vector<GameData *> &boards, int rel, int min_ms ) -> Result
+{
+    auto samples = make_samples( boards, rel );
+
+    double level_ns = time_ns( min_ms, samples.size(), [&]() {
+        for( auto &sample : samples )
+        {
+            sample.board->push_level();
+            sample.board->pop_level();
+        }
+    } );
+
+    double check_ns = time_ns( min_ms, samples.size(), [&]() {
+        int fired = 0;
+        for( auto &sample : samples )
+        {
+            sample.board->push_level();
+            fired += ( sample.board->*check_kernel[rel] )( sample.clue ).valid;
+            sample.board->pop_level();
+        }
+        sink = fired;
+    } );
+
+    double compatible_ns = time_ns( min_ms, samples.size(), [&]() {
+        int compatible = 0;
+        for( auto &sample : samples )
+        {
+            compatible += ( sample.board->*compatible_kernel[rel] )( sample.clue );
+        }
+        sink = compatible;
+    } );
+
+    return { check_ns - level_ns, compatible_ns };
+}
+
+static auto load_results( const char *filename, std::map<std::string, Result> *results ) -> int
+{
+    FILE *fp = fopen( filename, "r" );
+    if( !fp )
+    {
+        return 0;
+    }
+
+    char name[64];
+    Result result;
+    while( fscanf( fp, "%63s %lf %lf", name, &result.check_ns, &result.compatible_ns ) == 3 )
+    {
+        ( *results )[name] = result;
+    }
+    fclose( fp );
+    return 1;
+}
+
+static void usage()
+{
+    fprintf( stderr, "usage: watson-bench-relations [-m min_ms] [-o results] [-b baseline]\n" );
+    fprintf( stderr, "  -m min_ms   minimum time of each measurement (default 200)\n" );
+    fprintf( stderr, "  -o results  save the ns/op of each relation\n" );
+    fprintf( stderr, "  -b baseline compare against results saved with -o\n" );
+}
+
+auto main( int argc, char **argv ) -> int
+{
+    int min_ms = 200;
+    const char *output = nullptr;
+    const char *baseline_file = nullptr;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( i + 1 >= argc )
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if( !strcmp( argv[i], "-m" ) )
+        {
+            min_ms = atoi( argv[++i] );
+        }
+        else if( !strcmp( argv[i], "-o" ) )
+        {
+            output = argv[++i];
+        }
+        else if( !strcmp( argv[i], "-b" ) )
+        {
+            baseline_file = argv[++i];
+        }
+        else
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::map<std::string, Result> baseline;
+    if( baseline_file && !load_results( baseline_file, &baseline ) )
+    {
+        fprintf( stderr, "can't read %s\n", baseline_file );
+        return EXIT_FAILURE;
+    }
+
+    spdlog::set_level( spdlog::level::warn );
+    reset_rel_params();
+
+    std::vector<GameData *> boards;
+    for( int size = 4; size <= 8; size++ )
+    {
+        for( int i = 0; i < BOARDS_PER_SIZE; i++ )
+        {
+            boards.push_back( make_board( size, size, 1000 * size + i ) );
+        }
+    }
+
+    FILE *fp = output ? fopen( output, "w" ) : nullptr;
+    if( output && !fp )
+    {
+        fprintf( stderr, "can't open %s\n", output );
+        return EXIT_FAILURE;
+    }
+
+    printf( "%-30s %12s %12s", "relation", "check ns/op", "compat ns/op" );
+    if( baseline_file )
+    {
+        printf( " %12s %12s", "check diff", "compat diff" );
+    }
+    printf( "\n" );
+
+    for( int rel = 0; rel < NUMBER_OF_RELATIONS; rel++ )
+    {
+        Result result = bench_relation( boards, rel, min_ms );
+
+        printf( "%-30s %12.1f %12.1f", relation_name[rel], result.check_ns, result.compatible_ns );
+        auto base = baseline.find( relation_name[rel] );
+        if( base != baseline.end() )
+        {
+            printf( " %+11.1f%% %+11.1f%%",
+                    100.0 * ( result.check_ns / base->second.check_ns - 1.0 ),
+                    100.0 * ( result.compatible_ns / base->second.compatible_ns - 1.0 ) );
+        }
+        printf( "\n" );
+
+        if( fp )
+        {
+            fprintf( fp, "%s %.2f %.2f\n", relation_name[rel], result.check_ns, result.compatible_ns );
+        }
+    }
+
+    if( fp )
+    {
+        fclose( fp );
+    }
+
+    for( auto *board : boards )
+    {
+        delete board;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -636,7 +636,7 @@ auto make_clue_bitmaps( GameData *game_data, Board *board ) -> int
     ALLEGRO_BITMAP *dispbuf = al_get_target_bitmap();
     al_set_target_bitmap( nullptr );
 
-    for( int i = 0; i < game_data->clue_n; i++ )
+    for( int i = 0; i < game_data->clues.size(); i++ )
     {
         board->clue_bmp[i] = al_create_bitmap( board->clue_tiledblock[i]->width, board->clue_tiledblock[i]->height );
         if( !board->clue_bmp[i] )
@@ -156,8 +156,8 @@ auto Board::create_board( GameData *game_data, CreateMode mode ) -> int
 
     if( mode != CreateMode::Update )
     {
-        clue_bmp.resize( game_data->clue_n, nullptr );
-        clue_tiledblock.resize( game_data->clue_n, nullptr );
+        clue_bmp.resize( game_data->clues.size(), nullptr );
+        clue_tiledblock.resize( game_data->clues.size(), nullptr );
     }
 
     if( max_height * INFO_PANEL_PORTION - 2 * INFO_PANEL_MARGIN < 32 )
@@ -330,7 +330,7 @@ auto Board::create_board( GameData *game_data, CreateMode mode ) -> int
     {
         number_of_vclues = 0;
         number_of_hclues = 0;
-        for( int i = 0; i < game_data->clue_n; i++ )
+        for( int i = 0; i < game_data->clues.size(); i++ )
         {
             if( is_vclue( game_data->clues[i].rel ) )
             {
@@ -422,7 +422,7 @@ auto Board::create_board( GameData *game_data, CreateMode mode ) -> int
     {
         int j = 0;
         int k = 0;
-        for( int i = 0; i < game_data->clue_n; i++ )
+        for( int i = 0; i < game_data->clues.size(); i++ )
         {
             if( is_vclue( game_data->clues[i].rel ) )
             {
@@ -2,6 +2,7 @@
 
 #include "game.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
@@ -20,6 +21,7 @@
 
 #include "macros.hpp"
 #include "game_data.hpp"
+#include "puzzle_prefetcher.hpp"
 #include "sound.hpp"
 #include "tiled_block.hpp"
 #include "board.hpp"
@@ -62,15 +64,17 @@ Game::Game()
       desktop_height( 0 ),
       fullscreen( false ),
       game_data(),
+      prefetcher(),
       board(),
-      undo( nullptr )
+      journal()
 {
 }
 
 auto Game::init() -> bool
 {
     // seed random number generator. comment out for debug
-    srand( (unsigned int)time( nullptr ) );
+    game_data.rng.seed( (uint64_t)time( nullptr ) );
+    prefetcher.start( game_data.rng.next() );
 
     SPDLOG_DEBUG( "Watson v" PRE_VERSION " - " PRE_DATE " has started." );
     if( init_allegro() )
@@ -147,6 +151,7 @@ auto Game::run() -> bool
 
 auto Game::cleanup() -> bool
 {
+    prefetcher.stop();
     destroy_everything();
     al_destroy_display( display );
     al_destroy_event_queue( gui.event_queue );
@@ -177,7 +182,10 @@ void Game::draw_stuff()
             if( board.blink )
             {
                 highlight_TiledBlock( board.rule_out );
-                highlight_TiledBlock( board.highlight );
+                if( board.highlight )
+                {
+                    highlight_TiledBlock( board.highlight );
+                }
             }
         }
         else
@@ -224,10 +232,9 @@ void Game::handle_mouse_click_panel_tile( TiledBlock *tiled_block, int mclick )
     int i = tiled_block->parent->parent->index;
     if( mclick == 1 )
     {
-        save_state();
-        if( game_data.tiles[i][j][k] )
+        if( game_data.has_tile( i, j, k ) )
         { // hide tile
-            game_data.hide_tile_and_check( { i, j, k } );
+            play_move( { i, j, k }, MOVE_HIDE );
             if( !set.sound_mute )
             {
                 play_sound( SOUND_HIDE_TILE );
@@ -236,10 +243,9 @@ void Game::handle_mouse_click_panel_tile( TiledBlock *tiled_block, int mclick )
     }
     else if( ( mclick == 2 ) || ( mclick == 4 ) )
     { // hold or right click
-        if( game_data.tiles[i][j][k] )
+        if( game_data.has_tile( i, j, k ) )
         {
-            save_state();
-            game_data.guess_tile( { i, j, k } );
+            play_move( { i, j, k }, MOVE_GUESS );
             if( !set.sound_mute )
             {
                 play_sound( SOUND_GUESS_TILE );
@@ -249,7 +255,7 @@ void Game::handle_mouse_click_panel_tile( TiledBlock *tiled_block, int mclick )
         { // tile was hidden, unhide
             if( !game_data.is_guessed( j, k ) )
             {
-                game_data.tiles[i][j][k] = 1;
+                play_move( { i, j, k }, MOVE_SHOW );
                 if( !set.sound_mute )
                 {
                     play_sound( SOUND_UNHIDE_TILE );
@@ -271,8 +277,9 @@ void Game::handle_mouse_click_panel_block( TiledBlock *tiled_block, int mclick )
         && ( game_data.guess[tiled_block->parent->index][tiled_block->index] >= 0 ) )
     {
         // we found guessed block - unguess it
-        save_state();
-        game_data.unguess_tile( tiled_block->parent->index, tiled_block->index );
+        int column = tiled_block->parent->index;
+        int row = tiled_block->index;
+        play_move( { column, row, game_data.guess[column][row] }, MOVE_UNGUESS );
         if( !set.sound_mute )
         {
             play_sound( SOUND_UNHIDE_TILE );
@@ -457,6 +464,8 @@ void Game::handle_mouse_click( TiledBlock *tiled_block, int mx, int my, int mcli
 
 void Game::update_board()
 {
+    game_data.update_hints();
+
     for( int i = 0; i < game_data.number_of_columns; i++ )
     {
         auto column = board.panel.sub[i];
@@ -477,7 +486,7 @@ void Game::update_board()
 
                 for( int k = 0; k < game_data.number_of_columns; k++ )
                 {
-                    if( game_data.tiles[i][j][k] )
+                    if( game_data.has_tile( i, j, k ) )
                     {
                         block->sub[k]->hidden = TiledBlock::Visibility::Visible;
                     }
@@ -586,9 +595,15 @@ void Game::show_hint()
     {
         return;
     }
-    if( !game_data.check_panel_correctness() )
-    {
-        show_info_text( &board, al_ustr_new( "Something is wrong. An item was ruled out incorrectly." ) );
+    if( !game_data.mistakes.empty() )
+    { // point at the first one
+        auto &tile = game_data.mistakes.front();
+        board.highlight = nullptr;
+        board.rule_out = board.panel.sub[tile.column]->sub[tile.row];
+        show_info_text( &board,
+                        al_ustr_newf( "Something is wrong. %d item(s) were ruled out incorrectly, the first one of "
+                                      "them from the highlighted block.",
+                                      int( game_data.mistakes.size() ) ) );
         return;
     }
 
@@ -599,9 +614,27 @@ void Game::show_hint()
         return;
     }
 
-    board.highlight = board.clue_tiledblock[hint.clue_number];
+    board.highlight = hint.clue_number >= 0 ? board.clue_tiledblock[hint.clue_number] : nullptr;
     board.rule_out = board.panel.sub[hint.tile.column]->sub[hint.tile.row]->sub[hint.tile.cell];
 
+    if( hint.clue_number < 0 )
+    { // ruled out by the search, no single guess contradicts a clue
+        char *b3 = symbol_char[hint.tile.row][hint.tile.cell];
+        const char *fmt = "Suppose %s is here. Some more guessing from there leads to a contradiction, "
+                          "so we can rule out %s from here.";
+        show_info_text( &board, al_ustr_newf( fmt, b3, b3 ) );
+        return;
+    }
+
+    if( !hint.chain.empty() )
+    { // what if: the highlighted clue is the one the guess ends up contradicting
+        char *b3 = symbol_char[hint.tile.row][hint.tile.cell];
+        const char *fmt = "Suppose %s is here. Following %d more clue(s) from there, the highlighted clue can't hold, "
+                          "so we can rule out %s from here.";
+        show_info_text( &board, al_ustr_newf( fmt, b3, int( hint.chain.size() ) - 1, b3 ) );
+        return;
+    }
+
     auto &clue = game_data.clues[hint.clue_number];
     auto &tile0 = clue.tile[0];
     auto &tile1 = clue.tile[1];
@@ -615,89 +648,34 @@ void Game::show_hint()
     show_info_text( &board, get_hint_info_text( clue.rel, b0, b1, b2, b3 ) );
 }
 
-void Game::update_guessed()
+void Game::play_move( TileAddress tile, MOVE_OP op )
 {
-    int i;
-    int j;
-    int k;
-    int count;
-    int val;
-
-    game_data.guessed = 0;
-
-    for( i = 0; i < game_data.number_of_columns; i++ )
-    {
-        for( j = 0; j < game_data.column_height; j++ )
-        {
-            count = 0;
-            val = -1;
-            for( k = 0; k < game_data.number_of_columns; k++ )
-            {
-                if( game_data.tiles[i][j][k] )
-                {
-                    count++;
-                    val = k;
-                    if( count > 1 )
-                    {
-                        break;
-                    }
-                }
-            }
-            if( count == 1 )
-            {
-                game_data.guess[i][j] = val;
-                game_data.guessed++;
-            }
-            else
-            {
-                game_data.guess[i][j] = -1;
-            }
-        }
-    }
+    journal.play( game_data, tile, op );
 }
 
 void Game::execute_undo()
 {
-    if( !undo )
+    if( !journal.undo( game_data ) )
     {
         return;
     }
 
-    memcpy( &game_data.tiles, &undo->tile, sizeof( game_data.tiles ) );
-
-    auto *undo_old = undo->parent;
-
-    delete undo;
-
-    undo = undo_old;
-
     if( !set.sound_mute )
     {
         play_sound( SOUND_UNHIDE_TILE );
     }
-
-    update_guessed();
-}
-
-void Game::save_state()
-{
-    auto *foo = new PanelState();
-
-    foo->parent = undo;
-    undo = foo;
-
-    memcpy( &undo->tile, &game_data.tiles, sizeof( undo->tile ) );
 }
 
-void Game::destroy_undo()
+void Game::execute_redo()
 {
-    PanelState *foo;
+    if( !journal.redo( game_data ) )
+    {
+        return;
+    }
 
-    while( undo )
+    if( !set.sound_mute )
     {
-        foo = undo->parent;
-        delete undo;
-        undo = foo;
+        play_sound( SOUND_HIDE_TILE );
     }
 }
 
@@ -728,14 +706,14 @@ auto Game::save_game_f() -> int
         al_destroy_path( path );
         return -1;
     }
-    al_fwrite( fp, &game_data.number_of_columns, sizeof( game_data.number_of_columns ) );
-    al_fwrite( fp, &game_data.column_height, sizeof( game_data.column_height ) );
-    al_fwrite( fp, &game_data.puzzle, sizeof( game_data.puzzle ) );
-    al_fwrite( fp, &game_data.clue_n, sizeof( game_data.clue_n ) );
-    al_fwrite( fp, &game_data.clues, sizeof( game_data.clues ) );
-    al_fwrite( fp, &game_data.tiles, sizeof( game_data.tiles ) );
-    al_fwrite( fp, &game_data.time, sizeof( game_data.time ) );
-    al_fclose( fp );
+    auto data = game_data.save_game();
+    bool written = al_fwrite( fp, data.data(), data.size() ) == data.size();
+    if( !al_fclose( fp ) || !written )
+    {
+        SPDLOG_ERROR( "Couldn't write {}.", al_path_cstr( path, '/' ) );
+        al_destroy_path( path );
+        return -1;
+    }
 
     SPDLOG_DEBUG( "Saved game at %s.", al_path_cstr( path, '/' ) );
     al_destroy_path( path );
@@ -756,24 +734,19 @@ auto Game::load_game_f() -> int
         return -1;
     }
 
-    if( al_fread( fp, &game_data.number_of_columns, sizeof( game_data.number_of_columns ) )
-        != sizeof( game_data.number_of_columns ) )
+    // the file is read whole and checked before the game changes
+    int64_t size = al_fsize( fp );
+    std::vector<uint8_t> data( size > 0 ? size : 0 );
+    bool read = size > 0 && al_fread( fp, data.data(), data.size() ) == data.size();
+    al_fclose( fp );
+
+    if( !read || !game_data.load_game( data ) )
     {
+        SPDLOG_ERROR( "Bad game in the save file {}.", al_path_cstr( path, '/' ) );
         al_destroy_path( path );
-        SPDLOG_ERROR( "Error reading %s.", (char *)al_path_cstr( path, '/' ) );
         return -1;
     }
 
-    al_fread( fp, &game_data.column_height, sizeof( game_data.column_height ) );
-    al_fread( fp, &game_data.puzzle, sizeof( game_data.puzzle ) );
-    al_fread( fp, &game_data.clue_n, sizeof( game_data.clue_n ) );
-    al_fread( fp, &game_data.clues, sizeof( game_data.clues ) );
-    al_fread( fp, &game_data.tiles, sizeof( game_data.tiles ) );
-    al_fread( fp, &game_data.time, sizeof( game_data.time ) );
-    al_fclose( fp );
-
-    update_guessed();
-
     al_destroy_path( path );
 
     return 0;
@@ -1005,13 +978,13 @@ void Game::animate_win()
     draw_stuff();
     al_set_target_bitmap( currbuf );
 
-    int arr[64];
+    int arr[MAX_COLUMNS * MAX_ROWS];
     for( int k = 0; k < board.number_of_columns * board.column_height; k++ )
     {
         arr[k] = k;
     }
 
-    shuffle( arr, board.number_of_columns * board.column_height );
+    game_data.shuffle( arr, board.number_of_columns * board.column_height );
 
     for( int k = 0; k < board.number_of_columns * board.column_height; k++ )
     {
@@ -1058,29 +1031,98 @@ void Game::animate_win()
     }
 }
 
-void Game::draw_generating_puzzle( Settings *settings )
+void Game::draw_generating_puzzle( Settings *settings, bool can_cancel )
 {
     if( game_state == GAME_INTRO )
     {
         return;
     }
 
-    const char *fmt = nullptr;
+    const GenerationProgress &progress = prefetcher.get_progress();
+    const char *mode = difficulty_word( settings->difficulty );
+    int total = settings->number_of_columns * settings->column_height;
 
-    if( !settings->advanced )
+    ALLEGRO_USTR *msg = nullptr;
+    if( !progress.filter_total )
     {
-        fmt = "Generating %d x %d puzzle, please wait...";
+        msg = al_ustr_newf( "Generating %d x %d%s puzzle: %d clues placed, %d of %d cells solved...",
+                            settings->number_of_columns,
+                            settings->column_height,
+                            mode,
+                            (int)progress.clues,
+                            (int)progress.solved,
+                            total );
     }
     else
     {
-        fmt = "Generating %d x %d advanced puzzle, please wait (this could take a while)...";
+        msg = al_ustr_newf( "Generating %d x %d%s puzzle: removing extra clues, %d of %d checked...",
+                            settings->number_of_columns,
+                            settings->column_height,
+                            mode,
+                            (int)progress.filtered,
+                            (int)progress.filter_total );
     }
 
-    ALLEGRO_USTR *msg = al_ustr_newf( fmt, settings->number_of_columns, settings->column_height );
+    if( can_cancel )
+    {
+        al_ustr_append_cstr( msg, " Press ESC to cancel." );
+    }
 
     gui.draw_text_gui( msg );
 }
 
+// wait for the prefetcher, showing its progress. returns nullptr if the window was closed (noexit is cleared) or
+// can_cancel is set and ESC was pressed
+auto Game::wait_for_puzzle( bool can_cancel ) -> GameData *
+{
+    double draw_time = 0;
+    GameData *puzzle = nullptr;
+
+    while( !( puzzle = prefetcher.take() ) )
+    {
+        ALLEGRO_EVENT ev;
+        while( gui.event_queue && al_get_next_event( gui.event_queue, &ev ) )
+        {
+            switch( ev.type )
+            {
+                case ALLEGRO_EVENT_DISPLAY_HALT_DRAWING:
+                    halt( gui.event_queue );
+                    draw_time = 0;
+                    break;
+
+                case ALLEGRO_EVENT_DISPLAY_RESIZE:
+                    al_acknowledge_resize( display );
+                    draw_time = 0;
+                    break;
+
+                case ALLEGRO_EVENT_DISPLAY_CLOSE:
+                    noexit = false;
+                    return nullptr;
+
+                case ALLEGRO_EVENT_KEY_CHAR:
+                    if( can_cancel && ev.keyboard.keycode == ALLEGRO_KEY_ESCAPE )
+                    {
+                        return nullptr;
+                    }
+                    break;
+            }
+        }
+
+        if( al_get_time() - draw_time > 0.1 )
+        {
+            al_set_target_backbuffer( display );
+            draw_stuff();
+            draw_generating_puzzle( &set, can_cancel );
+            al_flip_display();
+            draw_time = al_get_time();
+        }
+
+        al_rest( 0.01 );
+    }
+
+    return puzzle;
+}
+
 auto Game::switch_tiles() -> int
 {
     // cycle through tyle types (font, bitmap, classic)
@@ -1159,7 +1201,7 @@ void Game::destroy_everything()
 {
     board.destroy_board();
     destroy_sound();
-    destroy_undo();
+    journal.clear();
     gui.remove_all_guis();
     gui.destroy_base_gui();
 }
@@ -1519,6 +1561,16 @@ void Game::handle_allegro_event_key_char( ALLEGRO_EVENT &ev )
             al_flush_event_queue( gui.event_queue );
             redraw = true;
             break;
+        case ALLEGRO_KEY_Y:
+            if( game_state != GAME_PLAYING )
+            {
+                break;
+            }
+            execute_redo();
+            update_board();
+            al_flush_event_queue( gui.event_queue );
+            redraw = true;
+            break;
         default:
             break;
     }
@@ -1726,6 +1778,9 @@ void Game::game_inner_loop()
 
     gui.update_base_gui( dt );
 
+    // keep the puzzle for the next new game ready
+    prefetcher.request( nset.number_of_columns, nset.column_height, nset.difficulty );
+
     handle_events();
     if( restart != RESTART_STATE::NO_RESTART )
     {
@@ -1792,20 +1847,42 @@ void Game::game_loop()
 
     if( restart != RESTART_STATE::LOADED_GAME )
     {
-        game_data.advanced = set.advanced; // use "what if" depth 1?
-        game_data.number_of_columns = set.number_of_columns;
-        game_data.column_height = set.column_height;
+        // a new game can be cancelled back to the current one, the first one can't
+        bool can_cancel = restart == RESTART_STATE::NEW_GAME;
+
+        prefetcher.request( set.number_of_columns, set.column_height, set.difficulty );
+        GameData *puzzle = wait_for_puzzle( can_cancel );
+        if( !puzzle )
+        {
+            if( !noexit )
+            { // window closed
+                return;
+            }
+
+            // cancelled, keep playing the current game
+            SPDLOG_DEBUG( "New game cancelled" );
+            set.difficulty = nset.difficulty = DIFFICULTY( game_data.advanced );
+            set.number_of_columns = nset.number_of_columns = game_data.number_of_columns;
+            set.column_height = nset.column_height = game_data.column_height;
+            restart = RESTART_STATE::NO_RESTART;
+            redraw = true;
+            old_time = al_get_time();
+            al_flush_event_queue( gui.event_queue );
+            play_game();
+            return;
+        }
+
+        Rng rng = game_data.rng;
+        game_data = *puzzle;
+        game_data.rng = rng;
         game_data.time = 0;
-        draw_stuff();
-        draw_generating_puzzle( &set );
-        al_flip_display();
-        game_data.create_game_with_clues();
+        delete puzzle;
     }
     else
     {
         // board should be updated only after destroying the board
         SPDLOG_DEBUG( "Resuming loaded game" );
-        set.advanced = game_data.advanced;
+        set.difficulty = DIFFICULTY( game_data.advanced );
         set.number_of_columns = game_data.number_of_columns;
         set.column_height = game_data.column_height;
     }
@@ -1832,7 +1909,7 @@ void Game::game_loop()
     {
         al_set_target_backbuffer( display );
         board.destroy_board();
-        destroy_undo();
+        journal.clear();
         al_set_target_backbuffer( display );
     }
 
@@ -1932,6 +2009,11 @@ void Game::game_loop()
     al_flush_event_queue( gui.event_queue );
     play_time = old_time = al_get_time();
 
+    play_game();
+}
+
+void Game::play_game()
+{
     while( noexit )
     {
         game_inner_loop();
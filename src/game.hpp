@@ -24,6 +24,8 @@
 #include "game_data.hpp"
 #include "gui.hpp"
 #include "macros.hpp"
+#include "move_journal.hpp"
+#include "puzzle_prefetcher.hpp"
 #include "sound.hpp"
 #include "text.hpp"
 #include "tiled_block.hpp"
@@ -39,16 +41,6 @@ constexpr double BLINK_DELAY = 0.3;
 constexpr double BLINK_TIME = 0.05;
 constexpr double FIXED_DT = 1.0 / FPS;
 
-constexpr size_t MAX_COLUMNS = 8;
-constexpr size_t MAX_ROWS = 8;
-constexpr size_t MAX_CELLS = 8;
-
-struct PanelState
-{
-    std::array<std::array<std::array<int, MAX_CELLS>, MAX_ROWS>, MAX_COLUMNS> tile;
-    PanelState *parent;
-};
-
 class Game
 {
 public:
@@ -74,7 +66,6 @@ private:
     void mouse_grab( int mx, int my );
     void mouse_drop( int mx, int my );
     auto get_TiledBlock_at( int x, int y ) -> TiledBlock *;
-    void destroy_undo();
     auto get_hint_info_text( RELATION relation, char *b0, char *b1, char *b2, char *b3 ) -> ALLEGRO_USTR *;
     void explain_clue( Clue *clue );
     void game_loop();
@@ -83,16 +74,17 @@ private:
     void draw_stuff();
     void update_board();
     void show_hint();
-    void update_guessed();
+    void play_move( TileAddress tile, MOVE_OP op );
     void execute_undo();
-    void save_state();
+    void execute_redo();
     void switch_solve_puzzle();
     auto save_game_f() -> int;
     auto load_game_f() -> int;
     void swap_clues( TiledBlock *c1, TiledBlock *c2 );
     void zoom_TB( TiledBlock *tiled_block );
     void animate_win();
-    void draw_generating_puzzle( Settings *settings );
+    void draw_generating_puzzle( Settings *settings, bool can_cancel );
+    auto wait_for_puzzle( bool can_cancel ) -> GameData *;
     auto switch_tiles() -> int;
     void win_or_lose();
 
@@ -115,6 +107,7 @@ private:
     void handle_allegro_event_mouse_axes( ALLEGRO_EVENT &ev );
     void handle_allegro_event_key_char( ALLEGRO_EVENT &ev );
 
+    void play_game();
     void game_inner_loop();
     auto game_inner_loop_check_resizing() -> bool;
     void game_inner_loop_check_double_click();
@@ -169,7 +162,8 @@ private:
     bool fullscreen;
 
     GameData game_data;
+    PuzzlePrefetcher prefetcher; // next puzzle for nset, made in the background
     Board board;
 
-    PanelState *undo;
+    MoveJournal journal; // the player's moves, for undo and redo
 };
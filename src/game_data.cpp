@@ -3,6 +3,10 @@
 #include "game_data.hpp"
 
 #include <algorithm> // for std::swap
+#include <atomic>
+#include <chrono>
+#include <cstring> // for memset
+#include <thread>
 
 #include <spdlog/spdlog.h>
 
@@ -32,13 +36,239 @@ const int DEFAULT_REL_PERCENT[NUMBER_OF_RELATIONS] = { 20, 5, 2, 3, 5, 25, 1, 20
 
 int REL_PERCENT[NUMBER_OF_RELATIONS] = { -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
-// xxx todo: fix rel_percent_max when rel_percent changes!!!
-int REL_PERCENT_MAX;
-
 // Prototypes
 //void get_clue( int column, int row, Clue *clue );
 //int filter_clues( GameData *game_data );
 
+// Bitboard helpers
+// every row of the board is a RowBits: lane [cell] holds the columns where the item is still available. the lanes
+// are lane_bits( cells_in_use ) wide, and the helpers only read the words of the cells in use. in the solver kernels
+// both are constants, so the loops unroll and a board of up to 8 columns works on one word a row
+static auto bit_index( uint64_t x ) -> int // index of lowest set bit, x must not be 0
+{
+#if defined( __GNUC__ )
+    return __builtin_ctzll( x );
+#else
+    int i = 0;
+    while( !( x & 1 ) )
+    {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static auto high_bit_index( unsigned x ) -> int // index of highest set bit, x must not be 0
+{
+#if defined( __GNUC__ )
+    return 31 - __builtin_clz( x );
+#else
+    int i = 0;
+    while( x >>= 1 )
+    {
+        i++;
+    }
+    return i;
+#endif
+}
+
+static auto bit_count( unsigned x ) -> int
+{
+#if defined( __GNUC__ )
+    return __builtin_popcount( x );
+#else
+    int n = 0;
+    for( ; x; x &= x - 1 )
+    {
+        n++;
+    }
+    return n;
+#endif
+}
+
+// the row helpers are written for a lane width of Lane bits. the ones without a Lane pick it from the board, so a
+// board of up to 8 columns works on a single word; the branch folds away when the size is known at compile time
+template<int Lane>
+constexpr uint64_t LANE_LOW = Lane == 8 ? 0x0101010101010101ULL : 0x0001000100010001ULL; // bit 0 of every lane
+
+template<int Lane>
+constexpr uint64_t LANE_HIGH = LANE_LOW<Lane> << ( Lane - 1 ); // the top bit of every lane
+
+template<int Lane>
+constexpr auto words_in( int cells_in_use ) -> int
+{
+    return Lane == 8 ? 1 : ( cells_in_use + 3 ) / 4;
+}
+
+static auto words_in_use( int cells_in_use ) -> int
+{
+    return cells_in_use <= 8 ? words_in<8>( cells_in_use ) : words_in<16>( cells_in_use );
+}
+
+template<int Lane>
+static auto nonzero_lanes( uint64_t x ) -> uint64_t // top bit of the lanes of x that are not 0
+{
+    constexpr uint64_t rest = ~LANE_HIGH<Lane>;
+    return ( ( ( x & rest ) + rest ) | x ) & LANE_HIGH<Lane>;
+}
+
+template<int Lane>
+static auto single_lanes( uint64_t x ) -> uint64_t // top bit of the lanes of x with exactly one bit set
+{
+    uint64_t less_one = ( ( x | LANE_HIGH<Lane> ) - LANE_LOW<Lane> ) ^ ( ~x & LANE_HIGH<Lane> ); // every lane - 1
+    return nonzero_lanes<Lane>( x ) & ~nonzero_lanes<Lane>( x & less_one );
+}
+
+template<int Lane>
+static auto gather_lanes( uint64_t high_bits ) -> unsigned // top bit of lane k to bit k
+{
+    if( Lane == 8 )
+    {
+        return unsigned( ( ( high_bits >> 7 ) * 0x0102040810204080ULL ) >> 56 );
+    }
+    return unsigned( ( ( high_bits >> 15 ) * 0x0001000200040008ULL ) >> 48 ) & 0xF;
+}
+
+// cells of a row where the lanes are not 0, and where they have exactly one bit set
+template<int Lane>
+static auto nonzero_cells( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    unsigned cells = 0;
+    for( int w = 0; w < words_in<Lane>( cells_in_use ); w++ )
+    {
+        cells |= gather_lanes<Lane>( nonzero_lanes<Lane>( row.word[w] ) ) << ( 64 / Lane * w );
+    }
+    return cells;
+}
+
+template<int Lane>
+static auto single_lane_cells( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    unsigned cells = 0;
+    for( int w = 0; w < words_in<Lane>( cells_in_use ); w++ )
+    {
+        cells |= gather_lanes<Lane>( single_lanes<Lane>( row.word[w] ) ) << ( 64 / Lane * w );
+    }
+    return cells;
+}
+
+// columns where some cell of row is set (once), and where more than one is (twice)
+template<int Lane>
+static void fold_columns( const RowBits &row, int cells_in_use, unsigned *once, unsigned *twice )
+{
+    uint64_t one = 0;
+    uint64_t two = 0;
+    for( int w = 0; w < words_in<Lane>( cells_in_use ); w++ )
+    {
+        two |= one & row.word[w];
+        one |= row.word[w];
+    }
+    two |= ( one & ( one >> 32 ) ) | ( two >> 32 );
+    one |= one >> 32;
+    two |= ( one & ( one >> 16 ) ) | ( two >> 16 );
+    one |= one >> 16;
+    if( Lane == 8 )
+    {
+        two |= ( one & ( one >> 8 ) ) | ( two >> 8 );
+        one |= one >> 8;
+    }
+    *once = unsigned( one ) & ( ( 1u << Lane ) - 1 );
+    *twice = unsigned( two ) & ( ( 1u << Lane ) - 1 );
+}
+
+template<int Lane>
+static auto or_columns( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    uint64_t columns = 0;
+    for( int w = 0; w < words_in<Lane>( cells_in_use ); w++ )
+    {
+        columns |= row.word[w];
+    }
+    columns |= columns >> 32;
+    columns |= columns >> 16;
+    if( Lane == 8 )
+    {
+        columns |= columns >> 8;
+    }
+    return unsigned( columns ) & ( ( 1u << Lane ) - 1 );
+}
+
+template<int Lane>
+static auto cells_in_column( const RowBits &row, int cells_in_use, int column ) -> unsigned
+{
+    unsigned cells = 0;
+    for( int w = 0; w < words_in<Lane>( cells_in_use ); w++ )
+    {
+        cells |= gather_lanes<Lane>( ( ( row.word[w] >> column ) & LANE_LOW<Lane> ) << ( Lane - 1 ) )
+                 << ( 64 / Lane * w );
+    }
+    return cells;
+}
+
+// columns where some cell of row is set (once), and where more than one is (twice)
+static void count_columns( const RowBits &row, int cells_in_use, unsigned *once, unsigned *twice )
+{
+    cells_in_use <= 8 ? fold_columns<8>( row, cells_in_use, once, twice )
+                      : fold_columns<16>( row, cells_in_use, once, twice );
+}
+
+// columns where some cell of row is set
+static auto any_columns( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    return cells_in_use <= 8 ? or_columns<8>( row, cells_in_use ) : or_columns<16>( row, cells_in_use );
+}
+
+// cells of row set in some column
+static auto any_cells( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    return cells_in_use <= 8 ? nonzero_cells<8>( row, cells_in_use ) : nonzero_cells<16>( row, cells_in_use );
+}
+
+// cells of row set in exactly one column
+static auto single_cells( const RowBits &row, int cells_in_use ) -> unsigned
+{
+    return cells_in_use <= 8 ? single_lane_cells<8>( row, cells_in_use ) : single_lane_cells<16>( row, cells_in_use );
+}
+
+// cells of row set in column
+static auto column_cells( const RowBits &row, int cells_in_use, int column ) -> unsigned
+{
+    return cells_in_use <= 8 ? cells_in_column<8>( row, cells_in_use, column )
+                             : cells_in_column<16>( row, cells_in_use, column );
+}
+
+// bit 0 of every lane of a row on a board of cells_in_use
+static auto lane_low( int cells_in_use ) -> uint64_t
+{
+    return cells_in_use <= 8 ? LANE_LOW<8> : LANE_LOW<16>;
+}
+
+static auto all_columns( int number_of_columns ) -> unsigned
+{
+    return ( 1u << number_of_columns ) - 1;
+}
+
+// columns next to the given ones
+static auto neighbors( unsigned columns ) -> unsigned
+{
+    return ( columns << 1 ) | ( columns >> 1 );
+}
+
+// the hot paths of the solver are templates over the board size, so that their loops and masks are fixed at
+// compile time. one instance for every size from 4x4 to 8x8, and a generic one that reads the size at run time
+struct SolverKernels
+{
+    void ( GameData::*pop_level )();
+    auto ( GameData::*propagate_clues )( uint64_t *queue, std::vector<ProbeStep> *trace ) -> int;
+    auto ( GameData::*check_this_clue )( PackedClue clue ) -> TileAddress;
+    auto ( GameData::*is_dead_end )() -> int;
+    auto ( GameData::*fewest_tiles_block )( int *column, int *row ) -> int;
+    auto ( GameData::*solve_clues )( uint64_t *queue ) -> int;
+    auto ( GameData::*search_solutions )( int limit ) -> int;
+    auto ( GameData::*probe_tile )( TileAddress tile, std::vector<ProbeStep> *trace ) -> int;
+};
+
 auto is_vclue( RELATION rel ) -> int
 {
     return ( ( rel == TOGETHER_2 ) || ( rel == TOGETHER_3 ) || ( rel == NOT_TOGETHER ) || ( rel == TOGETHER_NOT_MIDDLE )
@@ -55,10 +285,10 @@ void reset_rel_params()
 
 void GameData::create_puzzle()
 {
-    int permutation[8];
+    int permutation[MAX_COLUMNS];
 
     guessed = 0;
-    for( int i = 0; i < 8; i++ )
+    for( int i = 0; i < MAX_COLUMNS; i++ )
     {
         permutation[i] = i;
     }
@@ -74,496 +304,308 @@ void GameData::create_puzzle()
     }
 }
 
-auto rand_int( int n ) -> int
-{ // make static
-    int limit = RAND_MAX - RAND_MAX % n;
-    int rnd;
-
-    do
+void Rng::seed( uint64_t seed )
+{
+    for( auto &word : state )
     {
-        rnd = rand();
-    } while( rnd >= limit );
-    return rnd % n;
+        uint64_t z = ( seed += 0x9E3779B97F4A7C15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+        word = z ^ ( z >> 31 );
+    }
 }
 
-static auto rand_sign() -> int
+static auto rotl( uint64_t x, int k ) -> uint64_t
 {
-    return ( rand() % 2 == 0 ) ? -1 : 1;
+    return ( x << k ) | ( x >> ( 64 - k ) );
 }
 
-void shuffle( int p[], int n )
+auto Rng::next() -> uint64_t
 {
-    for( int i = n - 1; i > 0; i-- )
+    uint64_t result = rotl( state[1] * 5, 7 ) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl( state[3], 45 );
+
+    return result;
+}
+
+auto Rng::uniform( int n ) -> int
+{
+    // multiply and keep the high word, rejecting the few low words that would make the result biased
+    uint64_t bound = uint32_t( n );
+    uint64_t product = ( next() >> 32 ) * bound;
+    if( uint32_t( product ) < bound )
     {
-        int j = rand_int( i + 1 );
-        std::swap( p[i], p[j] );
+        uint32_t threshold = uint32_t( -bound ) % bound;
+        while( uint32_t( product ) < threshold )
+        {
+            product = ( next() >> 32 ) * bound;
+        }
     }
+    return int( product >> 32 );
 }
 
-void GameData::remove_clue( int i )
+auto GameData::rand_int( int n ) -> int
 {
-    // swap clue[i] with last clue, reduce clue_n
-    clue_n--;
-    clues[i] = clues[clue_n];
+    return rng.uniform( n );
 }
 
-auto GameData::check_this_clue_reveal( Clue *clue ) -> TileAddress
+auto GameData::rand_sign() -> int
 {
-    TileAddress tile;
-
-    auto &tile0 = clue->tile[0];
+    return ( rng.next() >> 63 ) ? 1 : -1;
+}
 
-    if( this->guess[tile0.column][tile0.row] < 0 )
+void GameData::shuffle( int p[], int n )
+{
+    for( int i = n - 1; i > 0; i-- )
     {
-        tile = tile0;
-        tile.valid = true;
-        guess_tile( tile0 );
+        int j = rand_int( i + 1 );
+        std::swap( p[i], p[j] );
     }
-    return tile;
 }
 
-auto GameData::check_this_clue_one_side( Clue *clue ) -> TileAddress
+void GameData::remove_clue( int i )
 {
-    TileAddress tile;
+    // swap clue[i] with last clue, drop the last
+    clues[i] = clues.back();
+    clues.pop_back();
+}
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
+auto GameData::hide_clue_tiles( PackedClue clue, const unsigned hide[3] ) -> TileAddress
+{
+    TileAddress tile;
 
-    for( int column = 0; column < number_of_columns; column++ )
+    for( int m = 0; m < 3; m++ )
     {
-        if( tiles[column][tile1.row][tile1.cell] )
-        {
-            tile = { column, tile1.row, tile1.cell };
-            hide_tile_and_check( tile );
-        }
-        if( tiles[column][tile0.row][tile0.cell] )
+        if( hide[m] )
         {
-            break;
+            auto tile_m = clue.tile( m );
+            save_row( tile_m.row );
+            tiles[tile_m.row].hide( tile_m.cell, hide[m], lane_width() );
+            tile = { high_bit_index( hide[m] ), tile_m.row, tile_m.cell };
         }
     }
-    for( int column = number_of_columns - 1; column >= 0; column-- )
+    for( int m = 0; m < 3; m++ )
     {
-        if( tiles[column][tile0.row][tile0.cell] )
+        if( hide[m] )
         {
-            tile = { column, tile0.row, tile0.cell };
-            hide_tile_and_check( tile );
-        }
-        if( tiles[column][tile1.row][tile1.cell] )
-        {
-            break;
+            check_row( clue.tile( m ).row );
         }
     }
     return tile;
 }
 
-auto GameData::check_this_clue_together_2( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_reveal( PackedClue clue ) -> TileAddress
 {
     TileAddress tile;
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
+    auto tile0 = clue.tile( 0 );
 
-    for( int column = 0; column < number_of_columns; column++ )
+    if( this->guess[tile0.column][tile0.row] < 0 )
     {
-        if( !tiles[column][tile0.row][tile0.cell] || !tiles[column][tile1.row][tile1.cell] )
-        {
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                tile = { column, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-        }
+        tile = tile0;
+        tile.valid = true;
+        guess_tile( tile0 );
     }
     return tile;
 }
 
-auto GameData::check_this_clue_together_3( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_one_side( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    return check_this_clue_one_side_for<0>( clue );
+}
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+template<int Columns>
+auto GameData::check_this_clue_one_side_for( PackedClue clue ) -> TileAddress
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( !tiles[column][tile0.row][tile0.cell] || !tiles[column][tile1.row][tile1.cell]
-            || !tiles[column][tile2.row][tile2.cell] )
-        { // if one exists but one doesn't
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                tile = { column, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-            if( tiles[column][tile2.row][tile2.cell] )
-            {
-                tile = { column, tile2.row, tile2.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+
+    // second can't be on or left of the leftmost first, first can't be on or right of the rightmost second
+    unsigned first_left = mask0 ? ( mask0 & ( ~mask0 + 1 ) ) : ( 1u << board_columns<Columns>() );
+    unsigned second_right = mask1 ? ( 1u << high_bit_index( mask1 ) ) : 1u;
+
+    unsigned hide[3] = { mask0 & ~( second_right - 1 ), mask1 & ( ( first_left << 1 ) - 1 ), 0 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_together_not_middle( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_together_2( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( ( this->guess[column][tile0.row] == tile0.cell ) || ( this->guess[column][tile2.row] == tile2.cell ) )
-        {
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-        if( ( !tiles[column][tile0.row][tile0.cell] ) || ( this->guess[column][tile1.row] == tile1.cell )
-            || !tiles[column][tile2.row][tile2.cell] )
-        {
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                tile = { column, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-            if( tiles[column][tile2.row][tile2.cell] )
-            {
-                tile = { column, tile2.row, tile2.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+    unsigned hide[3] = { mask0 & ~mask1, mask1 & ~mask0, 0 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_not_together( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_together_3( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
+    unsigned together = mask0 & mask1 & mask2;
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( ( this->guess[column][tile0.row] == tile0.cell ) && tiles[column][tile1.row][tile1.cell] )
-        {
-            tile = { column, tile1.row, tile1.cell };
-            hide_tile_and_check( tile );
-        }
-        if( ( this->guess[column][tile1.row] == tile1.cell ) && tiles[column][tile0.row][tile0.cell] )
-        {
-            tile = { column, tile0.row, tile0.cell };
-            hide_tile_and_check( tile );
-        }
-    }
-    return tile;
+    unsigned hide[3] = { mask0 & ~together, mask1 & ~together, mask2 & ~together };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_next_to( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_together_not_middle( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
+    unsigned guess0 = guessed_mask( tile0.row, tile0.cell );
+    unsigned guess1 = guessed_mask( tile1.row, tile1.cell );
+    unsigned guess2 = guessed_mask( tile2.row, tile2.cell );
+    unsigned apart = ~mask0 | guess1 | ~mask2;
 
-    if( !tiles[1][tile0.row][tile0.cell] && tiles[0][tile1.row][tile1.cell] )
-    {
-        tile = { 0, tile1.row, tile1.cell };
-        hide_tile_and_check( tile );
-    }
-    if( !tiles[1][tile1.row][tile1.cell] && tiles[0][tile0.row][tile0.cell] )
-    {
-        tile = { 0, tile0.row, tile0.cell };
-        hide_tile_and_check( tile );
-    }
-    if( !tiles[number_of_columns - 2][tile0.row][tile0.cell] && tiles[number_of_columns - 1][tile1.row][tile1.cell] )
-    {
-        tile = { number_of_columns - 1, tile1.row, tile1.cell };
-        hide_tile_and_check( tile );
-    }
-    if( !tiles[number_of_columns - 2][tile1.row][tile1.cell] && tiles[number_of_columns - 1][tile0.row][tile0.cell] )
-    {
-        tile = { number_of_columns - 1, tile0.row, tile0.cell };
-        hide_tile_and_check( tile );
-    }
+    unsigned hide[3] = { mask0 & apart, mask1 & ( guess0 | guess2 ), mask2 & apart };
+    return hide_clue_tiles( clue, hide );
+}
 
-    for( int column = 1; column < number_of_columns - 1; column++ )
-    {
-        if( !tiles[column - 1][tile0.row][tile0.cell] && !tiles[column + 1][tile0.row][tile0.cell] )
-        {
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-        if( !tiles[column - 1][tile1.row][tile1.cell] && !tiles[column + 1][tile1.row][tile1.cell] )
-        {
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                tile = { column, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+auto GameData::check_this_clue_not_together( PackedClue clue ) -> TileAddress
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned guess0 = guessed_mask( tile0.row, tile0.cell );
+    unsigned guess1 = guessed_mask( tile1.row, tile1.cell );
+
+    unsigned hide[3] = { mask0 & guess1, mask1 & guess0, 0 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_not_next_to( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_next_to( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( column < number_of_columns - 1 )
-        {
-            if( ( this->guess[column][tile0.row] == tile0.cell ) && tiles[column + 1][tile1.row][tile1.cell] )
-            {
-                tile = { column + 1, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
+    unsigned hide[3] = { mask0 & ~neighbors( mask1 ), mask1 & ~neighbors( mask0 ), 0 };
+    return hide_clue_tiles( clue, hide );
+}
 
-            if( ( this->guess[column][tile1.row] == tile1.cell ) && tiles[column + 1][tile0.row][tile0.cell] )
-            {
-                tile = { column + 1, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-        if( column > 0 )
-        {
-            if( ( this->guess[column][tile0.row] == tile0.cell ) && tiles[column - 1][tile1.row][tile1.cell] )
-            {
-                tile = { column - 1, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
+auto GameData::check_this_clue_not_next_to( PackedClue clue ) -> TileAddress
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-            if( ( this->guess[column][tile1.row] == tile1.cell ) && tiles[column - 1][tile0.row][tile0.cell] )
-            {
-                tile = { column - 1, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned guess0 = guessed_mask( tile0.row, tile0.cell );
+    unsigned guess1 = guessed_mask( tile1.row, tile1.cell );
+
+    unsigned hide[3] = { mask0 & neighbors( guess1 ), mask1 & neighbors( guess0 ), 0 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_consecutive( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_consecutive( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    return check_this_clue_consecutive_for<0>( clue );
+}
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+template<int Columns>
+auto GameData::check_this_clue_consecutive_for( PackedClue clue ) -> TileAddress
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    int hide_first = 0;
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        for( int m = 0; m < 2; m++ )
-        {
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                if( ( column < number_of_columns - 2 ) && ( column < 2 ) )
-                {
-                    if( ( !tiles[column + 1][tile1.row][tile1.cell] ) || ( !tiles[column + 2][tile2.row][tile2.cell] ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
-                if( ( column >= 2 ) && ( column >= number_of_columns - 2 ) )
-                {
-                    if( ( !tiles[column - 2][tile2.row][tile2.cell] ) || ( !tiles[column - 1][tile1.row][tile1.cell] ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
 
-                if( ( column >= 2 ) && ( column < number_of_columns - 2 ) )
-                {
-                    if( ( ( !tiles[column + 1][tile1.row][tile1.cell] )
-                          || ( !tiles[column + 2][tile2.row][tile2.cell] ) )
-                        && ( ( !tiles[column - 2][tile2.row][tile2.cell] )
-                             || ( !tiles[column - 1][tile1.row][tile1.cell] ) ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
-                if( hide_first )
-                {
-                    hide_first = 0;
-                    tile = { column, tile0.row, tile0.cell };
-                    hide_tile_and_check( tile );
-                }
-            }
-            std::swap( tile0.row, tile2.row );
-            std::swap( tile0.cell, tile2.cell );
-        }
+    // an outer tile needs the middle next to it and the other outer tile next to the middle
+    unsigned fits0 = ( ( mask1 >> 1 ) & ( mask2 >> 2 ) ) | ( ( mask1 << 1 ) & ( mask2 << 2 ) );
+    unsigned fits2 = ( ( mask1 >> 1 ) & ( mask0 >> 2 ) ) | ( ( mask1 << 1 ) & ( mask0 << 2 ) );
+    // the middle tile needs both outer tiles next to it, and can't be on the border
+    unsigned inner = all_columns( board_columns<Columns>() ) & ~1u & ~( 1u << ( board_columns<Columns>() - 1 ) );
+    unsigned fits1 = neighbors( mask0 ) & neighbors( mask2 ) & inner;
 
-        if( tiles[column][tile1.row][tile1.cell] )
-        {
-            if( ( column == 0 ) || ( column == number_of_columns - 1 ) )
-            {
-                hide_first = 1;
-            }
-            else
-            {
-                if( ( ( !tiles[column - 1][tile0.row][tile0.cell] ) && !( tiles[column + 1][tile0.row][tile0.cell] ) )
-                    || ( ( !tiles[column - 1][tile2.row][tile2.cell] )
-                         && !( tiles[column + 1][tile2.row][tile2.cell] ) ) )
-                { // error here! incorrect check!
-                    hide_first = 1;
-                }
-            }
-            if( hide_first )
-            {
-                hide_first = 0;
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+    unsigned hide[3] = { mask0 & ~fits0, mask1 & ~fits1, mask2 & ~fits2 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_not_middle( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_not_middle( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
+    unsigned guess0 = guessed_mask( tile0.row, tile0.cell );
+    unsigned guess1 = guessed_mask( tile1.row, tile1.cell );
+    unsigned guess2 = guessed_mask( tile2.row, tile2.cell );
 
-    int hide_first = 0;
-    for( int column = 0; column < number_of_columns; column++ )
-    { // apply mask
-        for( int m = 0; m < 2; m++ )
-        {
-            if( tiles[column][tile0.row][tile0.cell] )
-            {
-                if( ( column < number_of_columns - 2 ) && ( column < 2 ) )
-                {
-                    if( ( this->guess[column + 1][tile1.row] == tile1.cell )
-                        || ( !tiles[column + 2][tile2.row][tile2.cell] ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
-                if( ( column >= 2 ) && ( column >= number_of_columns - 2 ) )
-                {
-                    if( ( this->guess[column - 1][tile1.row] == tile1.cell )
-                        || ( !tiles[column - 2][tile2.row][tile2.cell] ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
+    // an outer tile needs the other one two columns away, without the middle tile guessed in between
+    unsigned free1 = ~guess1;
+    unsigned fits0 = ( ( free1 >> 1 ) & ( mask2 >> 2 ) ) | ( ( free1 << 1 ) & ( mask2 << 2 ) );
+    unsigned fits2 = ( ( free1 >> 1 ) & ( mask0 >> 2 ) ) | ( ( free1 << 1 ) & ( mask0 << 2 ) );
+    // the middle tile can't be between two guessed outer tiles
+    unsigned between = ( ( guess0 << 1 ) & ( guess2 >> 1 ) ) | ( ( guess2 << 1 ) & ( guess0 >> 1 ) );
 
-                if( ( column >= 2 ) && ( column < number_of_columns - 2 ) )
-                {
-                    if( ( ( this->guess[column + 1][tile1.row] == tile1.cell )
-                          || ( !tiles[column + 2][tile2.row][tile2.cell] ) )
-                        && ( ( !tiles[column - 2][tile2.row][tile2.cell] )
-                             || ( this->guess[column - 1][tile1.row] == tile1.cell ) ) )
-                    {
-                        hide_first = 1;
-                    }
-                }
-                if( hide_first )
-                {
-                    hide_first = 0;
-                    tile = { column, tile0.row, tile0.cell };
-                    hide_tile_and_check( tile );
-                }
-            }
-            std::swap( tile0.row, tile2.row );
-            std::swap( tile0.cell, tile2.cell );
-        }
-        if( ( column >= 1 ) && ( column <= number_of_columns - 2 ) )
-        {
-            if( ( ( this->guess[column - 1][tile0.row] == tile0.cell )
-                  && ( this->guess[column + 1][tile2.row] == tile2.cell ) )
-                || ( ( this->guess[column - 1][tile2.row] == tile2.cell )
-                     && ( this->guess[column + 1][tile0.row] == tile0.cell ) ) )
-            {
-                if( tiles[column][tile1.row][tile1.cell] )
-                {
-                    tile = { column, tile1.row, tile1.cell };
-                    hide_tile_and_check( tile );
-                }
-            }
-        }
-    }
-    return tile;
+    unsigned hide[3] = { mask0 & ~fits0, mask1 & between, mask2 & ~fits2 };
+    return hide_clue_tiles( clue, hide );
 }
 
-auto GameData::check_this_clue_together_first_with_only_one( Clue *clue ) -> TileAddress
+auto GameData::check_this_clue_together_first_with_only_one( PackedClue clue ) -> TileAddress
 {
-    TileAddress tile;
-
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
     // xxx todo: check this
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( !tiles[column][tile1.row][tile1.cell] && !tiles[column][tile2.row][tile2.cell] )
-        {
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile0.row, tile0.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-        else if( this->guess[column][tile1.row] == tile1.cell )
-        {
-            if( tiles[column][tile2.row][tile2.cell] )
-            {
-                tile = { column, tile2.row, tile2.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-        else if( this->guess[column][tile2.row] == tile2.cell )
-        {
-            if( tiles[column][tile1.row][tile1.cell] )
-            {
-                tile = { column, tile1.row, tile1.cell };
-                hide_tile_and_check( tile );
-            }
-        }
-    }
-    return tile;
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
+    unsigned guess1 = guessed_mask( tile1.row, tile1.cell );
+    unsigned guess2 = guessed_mask( tile2.row, tile2.cell );
+
+    unsigned hide[3] = { 0, mask1 & guess2 & ~guess1, mask2 & guess1 };
+    return hide_clue_tiles( clue, hide );
 }
 
 auto GameData::check_this_clue( Clue *clue ) -> TileAddress
+{
+    return ( this->*solver->check_this_clue )( PackedClue( *clue ) );
+}
+
+template<int Columns>
+auto GameData::check_this_clue_for( PackedClue clue ) -> TileAddress
 {
     TileAddress tile;
 
-    switch( clue->rel )
+    switch( clue.rel() )
     {
         case REVEAL:
             tile = check_this_clue_reveal( clue );
             break;
         case ONE_SIDE:
-            tile = check_this_clue_one_side( clue );
+            tile = check_this_clue_one_side_for<Columns>( clue );
             break;
 
         case TOGETHER_2:
@@ -590,7 +632,7 @@ auto GameData::check_this_clue( Clue *clue ) -> TileAddress
             break;
 
         case CONSECUTIVE:
-            tile = check_this_clue_consecutive( clue );
+            tile = check_this_clue_consecutive_for<Columns>( clue );
             break;
 
         case NOT_MIDDLE:
@@ -611,7 +653,7 @@ auto GameData::check_solution() -> int
     {
         for( int row = 0; row < column_height; row++ )
         {
-            if( !tiles[column][row][puzzle[column][row]] )
+            if( !has_tile( column, row, puzzle[column][row] ) )
             {
                 return 0;
             }
@@ -621,84 +663,487 @@ auto GameData::check_solution() -> int
     return 1;
 }
 
-// save a backup copy of game data if type==0, restore the data if type==1
-void GameData::switch_game( int type )
+void GameData::push_level()
+{
+    trail_levels.push_back( { trail.size(), guessed, 0 } );
+}
+
+void GameData::pop_level()
 {
-    static int _tiles[8][8][8];
-    static int _guess[8][8];
-    static int _guessed;
+    ( this->*solver->pop_level )();
+}
+
+template<int Columns>
+void GameData::pop_level_for()
+{
+    auto &level = trail_levels.back();
+
+    while( trail.size() > level.trail_size )
+    {
+        auto &entry = trail.back();
+        tiles[entry.row] = entry.tiles;
+        guess_bits[entry.row] = entry.guess_bits;
+        for( int column = 0; column < board_columns<Columns>(); column++ )
+        {
+            this->guess[column][entry.row] = -1;
+        }
+        for( unsigned cells = any_cells( entry.guess_bits, board_columns<Columns>() ); cells; cells &= cells - 1 )
+        {
+            int cell = bit_index( cells );
+            this->guess[bit_index( entry.guess_bits.get( cell, board_lane<Columns>() ) )][entry.row] = cell;
+        }
+        trail.pop_back();
+    }
+    guessed = level.guessed;
 
-    if( type == 0 )
+    trail_levels.pop_back();
+}
+
+// store row in the trail before it changes, once per level
+void GameData::save_row( int row )
+{
+    if( trail_levels.empty() )
     {
-        memcpy( &_tiles, &tiles, sizeof( _tiles ) );
-        memcpy( &_guess, &this->guess, sizeof( guess ) );
-        _guessed = guessed;
+        return;
     }
 
-    std::swap( tiles, _tiles );
-    std::swap( this->guess, _guess );
-    std::swap( guessed, _guessed );
+    auto &level = trail_levels.back();
+    if( !( level.saved_rows & ( 1u << row ) ) )
+    {
+        level.saved_rows |= 1u << row;
+        trail.push_back( { row, tiles[row], guess_bits[row] } );
+    }
 }
 
-// returns a hint that contains a clue and a tile that can be ruled out with this clue
+// returns a hint that contains a clue and a tile that can be ruled out with this clue: the easiest deduction a
+// single clue makes on the board. when no clue rules out anything, the first "what if" step of the script that is
+// still open, or without a script a "what if" worked out now
 auto GameData::get_hint() -> Hint
-{ // still not working properly
-    int clue_number = 0;
-    TileAddress tile_to_rule_out;
+{
+    update_hints();
+    int best = -1;
+    for( int i = 0; i < clues.size(); i++ )
+    {
+        if( hint_cache.next[i].valid && ( best < 0 || hint_cache.cost[i] < hint_cache.cost[best] ) )
+        {
+            best = i;
+        }
+    }
+    if( best >= 0 )
+    {
+        return Hint( true, best, hint_cache.next[best] );
+    }
+
+    for( auto &step : script )
+    {
+        if( has_tile( step.column, step.row, step.cell ) )
+        {
+            return script_hint( step );
+        }
+    }
+    return get_what_if_hint();
+}
+
+// xxx todo: tune
+// how hard a relation is to read off the board: one column first, then neighbours, then the ones that reason about
+// both sides or what is in between
+static const int HINT_RELATION_COST[NUMBER_OF_RELATIONS] = {
+    3, // NEXT_TO
+    5, // NOT_NEXT_TO
+    3, // ONE_SIDE
+    4, // CONSECUTIVE
+    5, // NOT_MIDDLE
+    1, // TOGETHER_2
+    2, // TOGETHER_3
+    1, // NOT_TOGETHER
+    2, // TOGETHER_NOT_MIDDLE
+    3, // TOGETHER_FIRST_WITH_ONLY_ONE
+    0, // REVEAL
+};
+
+// a deduction costs more with a harder relation, and less the more tiles it rules out, most of all when that settles
+// blocks. the changes are the rows in the trail since the last push_level
+auto GameData::hint_cost( int rel ) -> int
+{
+    auto &level = trail_levels.back();
+    int lane = lane_width();
+    int removed = 0;
+    for( size_t i = level.trail_size; i < trail.size(); i++ )
+    {
+        auto &entry = trail[i];
+        for( int cell = 0; cell < number_of_columns; cell++ )
+        {
+            removed += bit_count( entry.tiles.get( cell, lane ) & ~tiles[entry.row].get( cell, lane ) );
+        }
+    }
+    return 16 * HINT_RELATION_COST[rel] - removed - 4 * ( guessed - level.guessed );
+}
+
+// the steps before this one are done on the board and no clue rules out anything on its own, so the board is a
+// subset of the one the step was found on, and the step still holds. it is explained by probing its tile again,
+// which finds the contradiction when one guess was enough; a tile the search ruled out comes without a clue
+auto GameData::script_hint( const ScriptStep &step ) -> Hint
+{
+    TileAddress tile = { step.column, step.row, step.cell };
+    update_hints();
+    Hint hint( true, -1, tile );
+    std::vector<ProbeStep> trace;
+    if( ( this->*solver->probe_tile )( tile, &trace ) )
+    {
+        hint.chain = contradiction_chain( trace );
+        hint.clue_number = hint.chain.back();
+    }
+    return hint;
+}
 
-    switch_game( 0 ); // store game_data
-    for( int i = 0; i < clue_n; i++ )
+// solve the puzzle from the board the player starts with, the way solve_clues goes, and keep the tiles ruled out by
+// the rounds of "what if" probes or the search, in order, in script. get_hint finds what the single clues rule out
+// by itself. the board is left as it was
+void GameData::record_script()
+{
+    script.clear();
+    select_solver();
+    watch_clues();
+    push_level();
+
+    DeepSearch search = {};
+    RowBits before[MAX_ROWS];
+    while( guessed < number_of_columns * column_height && !cancelled() )
     {
-        tile_to_rule_out = check_this_clue( &clues[i] );
-        if( tile_to_rule_out.valid )
+        int found = 0;
+        for( int i = 0; i < clues.size(); i++ )
         {
-            clue_number = i;
+            if( check_this_clue( &clues[i] ).valid )
+            {
+                found = 1;
+            }
+        }
+        if( found )
+        {
+            continue;
+        }
+
+        // the clues are at their fixpoint, as the probes need
+        std::copy( tiles, tiles + MAX_ROWS, before );
+        ClueSet queue( clue_words );
+        if( !this->advanced
+            || !( advanced_check_clues<0, 0>( queue.data() )
+                  || ( this->advanced >= EXPERT && deep_check_clues<0, 0>( queue.data(), search ) ) ) )
+        { // stuck
             break;
         }
+        record_removed( before );
+    }
+
+    pop_level();
+}
+
+// add the tiles ruled out since before to the script
+void GameData::record_removed( const RowBits before[] )
+{
+    int lane = lane_width();
+    for( int row = 0; row < column_height; row++ )
+    {
+        for( int cell = 0; cell < number_of_columns; cell++ )
+        {
+            unsigned removed = before[row].get( cell, lane ) & ~tiles[row].get( cell, lane );
+            for( ; removed; removed &= removed - 1 )
+            {
+                script.push_back( { uint8_t( bit_index( removed ) ), uint8_t( row ), uint8_t( cell ) } );
+            }
+        }
     }
-    switch_game( 1 ); // restore game
+}
+
+// xxx todo: tune
+constexpr double WHAT_IF_HINT_SECONDS = 0.005; // time for the probes of a what if hint
+
+// when no clue rules out anything on its own: probe the available tiles as advanced_check_clues does, with a trace,
+// and return the contradiction with the shortest chain of clues found within WHAT_IF_HINT_SECONDS
+auto GameData::get_what_if_hint() -> Hint
+{
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+
     Hint hint;
-    hint.valid = tile_to_rule_out.valid;
-    hint.clue_number = clue_number;
-    hint.tile = tile_to_rule_out;
+    std::vector<ProbeStep> trace;
+    for( int column = 0; column < number_of_columns; column++ )
+    {
+        for( int row = 0; row < column_height; row++ )
+        {
+            for( int cell = 0; cell < number_of_columns; cell++ )
+            {
+                if( !has_tile( column, row, cell ) || this->guess[column][row] >= 0 )
+                {
+                    continue;
+                }
+                if( std::chrono::duration<double>( clock::now() - start ).count() > WHAT_IF_HINT_SECONDS )
+                {
+                    return hint;
+                }
+
+                trace.clear();
+                if( ( this->*solver->probe_tile )( { column, row, cell }, &trace ) )
+                {
+                    auto chain = contradiction_chain( trace );
+                    if( !hint.valid || chain.size() < hint.chain.size() )
+                    {
+                        hint = Hint( true, chain.back(), { column, row, cell } );
+                        hint.chain = chain;
+                    }
+                }
+            }
+        }
+    }
     return hint;
 }
-auto GameData::advanced_check_clues() -> int
+
+// the clues of a probe trace that the contradiction depends on, as clue numbers. a clue reads the items it
+// mentions, and the whole row when check_row carries its change over to other items. going back from the broken
+// clue (last), a clue is needed if it changed an item that a needed clue reads
+auto GameData::contradiction_chain( const std::vector<ProbeStep> &trace ) -> std::vector<int>
+{
+    std::vector<int> chain;
+    unsigned needed[MAX_ROWS] = {}; // [row] cells
+    for( size_t i = trace.size(); i-- > 0; )
+    {
+        auto &step = trace[i];
+        PackedClue clue = clue_table.clue[step.slot];
+        unsigned reads[MAX_ROWS] = {};
+        for( int t = 0; t < 3; t++ )
+        {
+            reads[clue.tile( t ).row] |= 1u << clue.tile( t ).cell;
+        }
+        bool needs = i == trace.size() - 1;
+        for( int t = 0; t < 3; t++ )
+        {
+            int row = clue.tile( t ).row;
+            needs = needs || ( step.changed[t] & needed[row] );
+            if( step.changed[t] & ~reads[row] )
+            {
+                reads[row] = all_columns( MAX_CELLS );
+            }
+        }
+        if( needs )
+        {
+            for( int t = 0; t < 3; t++ )
+            {
+                needed[clue.tile( t ).row] |= reads[clue.tile( t ).row];
+            }
+            chain.push_back( clue_table.index[step.slot] );
+        }
+    }
+    std::reverse( chain.begin(), chain.end() );
+    return chain;
+}
+
+void GameData::reset_hints()
 {
-    int info;
+    hint_cache.ready = false;
+}
 
-    for( int column = 0; column < number_of_columns; column++ )
+void GameData::update_hints()
+{
+    select_solver();
+    ClueSet dirty;
+    if( !hint_cache.ready )
+    { // the watch lists may be for other clues
+        watch_clues();
+        hint_cache.next.assign( clues.size(), TileAddress() );
+        hint_cache.cost.assign( clues.size(), 0 );
+        dirty.resize( clue_words );
+        for( int slot = 0; slot < clues.size(); slot++ )
+        {
+            dirty[slot / 64] |= uint64_t( 1 ) << ( slot % 64 );
+        }
+        hint_cache.ready = true;
+    }
+    else
     {
+        // the cost counts what check_row carries over to the other items of the rows of a clue, so a clue is worked
+        // out again when any item of its rows changed, not only its own
+        dirty.resize( clue_words );
         for( int row = 0; row < column_height; row++ )
         {
+            if( !queue_changed_clues<0>( row, hint_cache.tiles[row], hint_cache.guess_bits[row], dirty.data() ) )
+            {
+                continue;
+            }
             for( int cell = 0; cell < number_of_columns; cell++ )
             {
-                if( tiles[column][row][cell] )
+                const uint64_t *watch = watchers( row, cell );
+                for( int w = 0; w < clue_words; w++ )
                 {
-                    switch_game( 0 ); // save state
-                    guess_tile( { column, row, cell } );
-                    do
-                    { // repeat until no more information remains in clues
-                        info = 0;
-                        for( int m = 0; m < clue_n; m++ )
-                        {
-                            if( check_this_clue( &clues[m] ).valid )
-                            {
-                                info = 1;
-                            }
-                        }
-                    } while( info );
-                    if( !check_panel_consistency() )
+                    dirty[w] |= watch[w];
+                }
+            }
+        }
+    }
+    std::copy( tiles, tiles + MAX_ROWS, hint_cache.tiles );
+    std::copy( guess_bits, guess_bits + MAX_ROWS, hint_cache.guess_bits );
+
+    for( int w = 0; w < clue_words; w++ )
+    {
+        for( uint64_t bits = dirty[w]; bits; bits &= bits - 1 )
+        {
+            int clue = clue_table.index[64 * w + bit_index( bits )];
+            push_level();
+            hint_cache.next[clue] = check_this_clue( &clues[clue] );
+            hint_cache.cost[clue] = hint_cost( clues[clue].rel );
+            pop_level();
+        }
+    }
+}
+// xxx todo: tune the search budgets
+constexpr long EXPERT_BUDGET = 100;    // nodes to rule out one tile in expert mode
+constexpr long NIGHTMARE_BUDGET = 400; // same for nightmare mode
+constexpr long PASS_BUDGET = 3000;     // nodes for all the tiles of a deep_check_clues
+constexpr size_t MAX_NOGOODS = 1024;
+constexpr size_t MINIMIZE_DEPTH = 3; // longest path whose dead ends are reduced to the guesses they need
+
+// a number for every tile of the largest board, for the nogoods
+static auto tile_index( const TileAddress &tile ) -> int
+{
+    return ( tile.row * MAX_COLUMNS + tile.column ) * MAX_CELLS + tile.cell;
+}
+
+static auto tile_at( int index ) -> TileAddress
+{
+    return { index / MAX_CELLS % MAX_COLUMNS, index / ( MAX_CELLS * MAX_COLUMNS ), index % MAX_CELLS };
+}
+
+// probe every available tile: if guessing it leads to an inconsistent panel, hide it
+// the probes of a round are independent, so they run in parallel, each worker on its own copy of the board
+template<int Columns, int Height>
+auto GameData::advanced_check_clues( uint64_t *queue ) -> int
+{
+    std::vector<TileAddress> candidates;
+    for( int column = 0; column < board_columns<Columns>(); column++ )
+    {
+        for( int row = 0; row < board_height<Height>(); row++ )
+        {
+            for( int cell = 0; cell < board_columns<Columns>(); cell++ )
+            {
+                // guessing the tile of a guessed block changes nothing, so it can't lead to a contradiction
+                if( has_tile( column, row, cell ) && this->guess[column][row] < 0 )
+                {
+                    candidates.push_back( { column, row, cell } );
+                }
+            }
+        }
+    }
+
+    std::vector<char> contradiction( candidates.size(), 0 );
+    std::atomic<size_t> next_candidate( 0 );
+
+    auto probe = [&]() {
+        GameData board = *this;
+        for( size_t i = next_candidate++; i < candidates.size(); i = next_candidate++ )
+        {
+            contradiction[i] = board.probe_tile<Columns>( candidates[i], nullptr );
+        }
+    };
+
+    // xxx todo: tune the number of probes that make a thread worth starting
+    int workers = threads > 0 ? threads : std::max( 1u, std::thread::hardware_concurrency() );
+    workers = std::min( workers, std::max( 1, int( candidates.size() / 16 ) ) );
+
+    std::vector<std::thread> pool;
+    for( int i = 1; i < workers; i++ )
+    {
+        pool.emplace_back( probe );
+    }
+    probe();
+    for( auto &thread : pool )
+    {
+        thread.join();
+    }
+
+    // a contradiction stays a contradiction with fewer tiles, so all of them can be applied
+    int ret = 0;
+    for( size_t i = 0; i < candidates.size(); i++ )
+    {
+        auto &tile = candidates[i];
+        if( contradiction[i] && has_tile( tile.column, tile.row, tile.cell ) )
+        {
+            RowBits old_tiles = tiles[tile.row];
+            RowBits old_guess_bits = guess_bits[tile.row];
+
+            hide_tile_and_check( tile );
+            queue_changed_clues<Columns>( tile.row, old_tiles, old_guess_bits, queue );
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+// expert and nightmare: rule out the tiles that a search finds no solution with. the search learns the guesses behind
+// every dead end (nogoods), and jumps back over the guesses that had no part in one
+// returns 1 if any tile was ruled out
+template<int Columns, int Height>
+auto GameData::deep_check_clues( uint64_t *queue, DeepSearch &search ) -> int
+{
+    search.max_depth = this->advanced == EXPERT ? 2 : board_columns<Columns>() * board_height<Height>();
+    search.budget = this->advanced == EXPERT ? EXPERT_BUDGET : NIGHTMARE_BUDGET;
+    memcpy( search.root_tiles, tiles, sizeof( tiles ) );
+    memcpy( search.root_guess_bits, guess_bits, sizeof( guess_bits ) );
+    search.pass_nodes = 0;
+    int lane = board_lane<Columns>();
+
+    for( int row = 0; row < board_height<Height>(); row++ )
+    {
+        for( int column = 0; column < board_columns<Columns>(); column++ )
+        {
+            for( unsigned cells = block_mask( column, row ); cells; cells &= cells - 1 )
+            {
+                if( cancelled() || search.pass_nodes > PASS_BUDGET )
+                {
+                    return 0;
+                }
+
+                TileAddress tile = { column, row, bit_index( cells ) };
+                if( this->guess[column][row] >= 0 || ( ( search.solution_tiles[row].get( tile.cell, lane ) >> column ) & 1 ) )
+                { // guessed, or part of a solution
+                    continue;
+                }
+
+                size_t learned = search.nogoods.size();
+                GuessSet conflict;
+
+                search.nodes = 0;
+                search.path.assign( 1, tile );
+                search.path_tiles[row].show( tile.cell, 1u << column, board_lane<Columns>() );
+                push_level();
+                propagate_guess<Columns>( tile );
+                refute<Columns, Height>( search, conflict ); // a refuted tile is learned as a nogood of its own
+                pop_level_for<Columns>();
+                search.path_tiles[row].hide( tile.cell, 1u << column, board_lane<Columns>() );
+
+                // the tile, and any other tile found on the way, that no solution can have
+                int found = 0;
+                for( size_t i = learned; i < search.nogoods.size(); i++ )
+                {
+                    if( search.nogoods[i].tiles.size() != 1 )
                     {
-                        switch_game( 1 ); // restore
-                        hide_tile_and_check( { column, row, cell } );
-                        return 1;
+                        continue;
                     }
-                    else
+                    TileAddress single = tile_at( search.nogoods[i].tiles[0] );
+                    if( has_tile( single.column, single.row, single.cell ) )
                     {
-                        switch_game( 1 ); // restore state
+                        RowBits old_tiles = tiles[single.row];
+                        RowBits old_guess_bits = guess_bits[single.row];
+
+                        hide_tile_and_check( single );
+                        queue_changed_clues<Columns>( single.row, old_tiles, old_guess_bits, queue );
+                        found = 1;
                     }
                 }
+
+                if( found )
+                { // let the cheaper deductions go first again
+                    return 1;
+                }
             }
         }
     }
@@ -706,309 +1151,599 @@ auto GameData::advanced_check_clues() -> int
     return 0;
 }
 
-auto GameData::check_clues() -> int
+// the guesses in search.path are on the board and propagated. returns 1 if no solution follows from them, with the
+// positions in the path of the guesses that lead to the dead end in conflict
+template<int Columns, int Height>
+auto GameData::refute( DeepSearch &search, GuessSet &conflict ) -> int
 {
-    // check whether the clues add new info (within reason -- this can be tuned)
-    // for now it does not combine clues (analyze each one separately)
-    // if so, discover the info in tiles
-    // return 1 if new info was found, 0 if not
-    int info;
+    // a dead end seen before. it has the last guess, or the search would have stopped before
+    if( !search.nogoods_with.empty() )
+    {
+        for( int i : search.nogoods_with[tile_index( search.path.back() )] )
+        {
+            auto &nogood = search.nogoods[i];
+            bool on_path = true;
+            for( int index : nogood.tiles )
+            {
+                TileAddress tile = tile_at( index );
+                if( !( ( search.path_tiles[tile.row].get( tile.cell, board_lane<Columns>() ) >> tile.column ) & 1 ) )
+                {
+                    on_path = false;
+                    break;
+                }
+            }
+            if( on_path )
+            {
+                conflict.reset();
+                for( size_t p = 0; p < search.path.size(); p++ )
+                {
+                    int index = tile_index( search.path[p] );
+                    if( std::find( nogood.tiles.begin(), nogood.tiles.end(), index ) != nogood.tiles.end() )
+                    {
+                        conflict.set( p );
+                    }
+                }
+                return 1;
+            }
+        }
+    }
 
-    int ret = 0;
-    do
-    { // repeat until no more information remains in clues
-        info = 0;
-        for( int m = 0; m < clue_n; m++ )
+    if( is_dead_end_for<Columns, Height>() )
+    {
+        // keep only the guesses it needs. the replays cost more than they save on long paths
+        conflict.reset();
+        for( size_t i = 0; i < search.path.size(); i++ )
         {
-            if( check_this_clue( &clues[m] ).valid )
+            conflict.set( i );
+        }
+        for( size_t i = 0; i < search.path.size() && search.path.size() <= MINIMIZE_DEPTH; i++ )
+        {
+            conflict.reset( i );
+            if( !replay_is_dead_end<Columns, Height>( search, conflict ) )
             {
-                ret = 1;
-                info = 1;
+                conflict.set( i );
             }
         }
-        if( !info && this->advanced )
-        { // check "what if" depth 1
-            while( advanced_check_clues() )
+        learn_nogood( search, conflict );
+        return 1;
+    }
+
+    int column;
+    int row;
+    if( !fewest_tiles_block_for<Columns, Height>( &column, &row ) )
+    { // a solution
+        for( int j = 0; j < board_height<Height>(); j++ )
+        {
+            for( int w = 0; w < words_in_use( board_columns<Columns>() ); w++ )
             {
-                info = 1;
+                search.solution_tiles[j].word[w] |= tiles[j].word[w];
             }
         }
-    } while( info );
+        return 0;
+    }
 
-    return ret;
+    if( (int)search.path.size() >= search.max_depth || ++search.nodes > search.budget
+        || ++search.pass_nodes > PASS_BUDGET )
+    { // out of depth or budget
+        return 0;
+    }
+
+    // the cells ruled out before the search are ruled out by the clues alone. those ruled out since are guessed as
+    // well: they fail at once, and the dead end finds the guesses that ruled them out
+    size_t position = search.path.size();
+    GuessSet node_conflict;
+    unsigned root_cells = column_cells( search.root_tiles[row], board_columns<Columns>(), column );
+    for( unsigned cells = root_cells; cells; cells &= cells - 1 )
+    {
+        TileAddress tile = { column, row, bit_index( cells ) };
+        GuessSet child_conflict;
+
+        push_level();
+        search.path.push_back( tile );
+        search.path_tiles[row].show( tile.cell, 1u << column, board_lane<Columns>() );
+        propagate_guess<Columns>( tile );
+        int refuted = refute<Columns, Height>( search, child_conflict );
+        search.path_tiles[row].hide( tile.cell, 1u << column, board_lane<Columns>() );
+        search.path.pop_back();
+        pop_level_for<Columns>();
+
+        if( !refuted )
+        {
+            return 0;
+        }
+        if( !child_conflict.test( position ) )
+        { // this guess had no part in the dead end, so the other cells of the block won't help: jump back
+            conflict = child_conflict;
+            return 1;
+        }
+
+        child_conflict.reset( position );
+        node_conflict |= child_conflict;
+    }
+
+    conflict = node_conflict;
+    learn_nogood( search, conflict );
+    return 1;
 }
 
-void GameData::create_game_with_clues()
+// whether the guesses of the path alone, on the board the search started from, lead to a dead end. the board is left
+// as it was
+template<int Columns, int Height>
+auto GameData::replay_is_dead_end( DeepSearch &search, const GuessSet &guesses ) -> int
 {
-    init_game();
-    create_puzzle();
+    ClueSet queue( clue_words );
 
-    clue_n = 0;
-    for( int i = 0; i < 100; i++ )
-    { // xxx todo add a check to see if we have found
-        // solution or not after 100
-        clue_n++;
-        do
+    push_level();
+    for( int row = 0; row < board_height<Height>(); row++ )
+    {
+        save_row( row );
+        tiles[row] = search.root_tiles[row];
+        guess_bits[row] = search.root_guess_bits[row];
+    }
+    for( size_t i = 0; i < search.path.size(); i++ )
+    {
+        if( guesses.test( i ) )
         {
-            get_clue( rand_int( number_of_columns ), rand_int( column_height ), &clues[clue_n - 1] );
-        } while( !check_this_clue( &clues[clue_n - 1] ).valid ); // should be while
-                                                                 // !check_clues?
-        check_clues();
-        if( guessed == number_of_columns * column_height )
+            auto &tile = search.path[i];
+            RowBits old_tiles = tiles[tile.row];
+            RowBits old_guess_bits = guess_bits[tile.row];
+
+            guess_tile( tile );
+            queue_changed_clues<Columns>( tile.row, old_tiles, old_guess_bits, queue.data() );
+        }
+    }
+    propagate_clues_for<Columns>( queue.data() );
+    int dead = is_dead_end_for<Columns, Height>();
+    pop_level_for<Columns>();
+
+    return dead;
+}
+
+void GameData::learn_nogood( DeepSearch &search, const GuessSet &conflict )
+{
+    if( conflict.none() || search.nogoods.size() >= MAX_NOGOODS )
+    {
+        return;
+    }
+    if( search.nogoods_with.empty() )
+    {
+        search.nogoods_with.resize( MAX_ROWS * MAX_COLUMNS * MAX_CELLS );
+    }
+
+    Nogood nogood;
+    for( size_t i = 0; i < search.path.size(); i++ )
+    {
+        if( conflict.test( i ) )
         {
-            break;
+            int index = tile_index( search.path[i] );
+            nogood.tiles.push_back( index );
+            search.nogoods_with[index].push_back( int( search.nogoods.size() ) );
         }
     }
+    search.nogoods.push_back( nogood );
+}
 
-    if( !check_solution() )
-    { // debug
-        SPDLOG_ERROR( "ERROR: SOLUTION DOESN'T MATCH CLUES" );
+// guess the tile and propagate the clues that watch its row. the board must be at the clue fixpoint
+template<int Columns>
+void GameData::propagate_guess( TileAddress tile, std::vector<ProbeStep> *trace )
+{
+    RowBits old_tiles = tiles[tile.row];
+    RowBits old_guess_bits = guess_bits[tile.row];
+    ClueSet queue( clue_words );
+
+    guess_tile( tile );
+    queue_changed_clues<Columns>( tile.row, old_tiles, old_guess_bits, queue.data() );
+    propagate_clues_for<Columns>( queue.data(), trace );
+}
+
+// "what if": 1 if guessing the tile leads to a panel the clues contradict. the board must be at the clue fixpoint,
+// and is left as it was. with trace, the clues that added new info are appended, then the broken one
+template<int Columns>
+auto GameData::probe_tile( TileAddress tile, std::vector<ProbeStep> *trace ) -> int
+{
+    push_level();
+    propagate_guess<Columns>( tile, trace );
+    int broken = broken_clue();
+    if( trace && broken >= 0 )
+    {
+        trace->push_back( { broken, {} } );
     }
+    pop_level_for<Columns>();
 
-    filter_clues();
-    SPDLOG_INFO( "{}x{} game created with {} clues", number_of_columns, column_height, clue_n );
+    return broken >= 0 ? 1 : 0;
+}
 
-    // clean guesses and tiles
-    init_game();
+// pack the clues into clue_table, grouped by relation, and index them by the items they mention
+void GameData::watch_clues()
+{
+    int count[NUMBER_OF_RELATIONS] = {};
+    for( int m = 0; m < clues.size(); m++ )
+    {
+        count[clues[m].rel]++;
+    }
+    clue_table.first[0] = 0;
+    for( int rel = 0; rel < NUMBER_OF_RELATIONS; rel++ )
+    {
+        clue_table.first[rel + 1] = clue_table.first[rel] + count[rel];
+        count[rel] = clue_table.first[rel];
+    }
 
-    // reveal reveal clues and remove them from clue list
-    for( int i = 0; i < clue_n; i++ )
+    clue_table.clue.resize( clues.size() );
+    clue_table.index.resize( clues.size() );
+    clue_words = ( clues.size() + 63 ) / 64;
+    clue_watch.assign( column_height * number_of_columns * clue_words, 0 );
+    for( int m = 0; m < clues.size(); m++ )
     {
-        auto &clue = clues[i];
-        if( clue.rel == REVEAL )
+        int slot = count[clues[m].rel]++;
+        clue_table.clue[slot] = PackedClue( clues[m] );
+        clue_table.index[slot] = m;
+        for( auto &tile : clues[m].tile )
         {
-            guess_tile( clue.tile[0] );
-            remove_clue( i );
-            i--;
+            watchers( tile.row, tile.cell )[slot / 64] |= uint64_t( 1 ) << ( slot % 64 );
         }
     }
+}
 
-    // mark clues unhidden
-    for( int i = 0; i < clue_n; i++ )
+// queue the clues that mention an item of row that changed since old_tiles/old_guess_bits
+// returns the cells that changed
+template<int Columns>
+auto GameData::queue_changed_clues( int row,
+                                    const RowBits &old_tiles,
+                                    const RowBits &old_guess_bits,
+                                    uint64_t *queue ) -> unsigned
+{
+    RowBits flipped;
+    for( int w = 0; w < words_in_use( board_columns<Columns>() ); w++ )
+    {
+        flipped.word[w] = ( old_tiles.word[w] ^ tiles[row].word[w] ) | ( old_guess_bits.word[w] ^ guess_bits[row].word[w] );
+    }
+    unsigned changed = any_cells( flipped, board_columns<Columns>() );
+    if( !changed )
     {
-        clues[i].hidden = false;
+        return 0;
+    }
+    // a word of the queue at a time, so that it stays in a register while the cells are added
+    const uint64_t *watch = watchers( row, 0 );
+    for( int w = 0; w < clue_words; w++ )
+    {
+        uint64_t words = 0;
+        for( unsigned cells = changed; cells; cells &= cells - 1 )
+        {
+            words |= watch[bit_index( cells ) * clue_words + w];
+        }
+        queue[w] |= words;
     }
+    return changed;
 }
 
-auto GameData::is_clue_compatible_reveal( Clue *clue ) -> int
+// check the queued clues until none is left, queueing again the clues whose items changed. with trace, every clue
+// that adds new info is appended to it
+// returns 1 if any clue added new info
+auto GameData::propagate_clues( uint64_t *queue, std::vector<ProbeStep> *trace ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    return ( this->*solver->propagate_clues )( queue, trace );
+}
+
+template<int Columns>
+auto GameData::propagate_clues_for( uint64_t *queue, std::vector<ProbeStep> *trace ) -> int
+{
+    int ret = 0;
 
-    if( tiles[clue->tile[0].column][tile0.row][tile0.cell] )
+    int w = 0;
+    while( w < clue_words )
     {
-        return 1;
+        if( !queue[w] )
+        {
+            w++;
+            continue;
+        }
+        int slot = 64 * w + bit_index( queue[w] );
+        queue[w] &= queue[w] - 1;
+
+        // a clue only changes the rows it mentions
+        PackedClue clue = clue_table.clue[slot];
+        int rows[3];
+        RowBits old_tiles[3];
+        RowBits old_guess_bits[3];
+        for( int t = 0; t < 3; t++ )
+        {
+            rows[t] = clue.tile( t ).row;
+            for( int w = 0; w < words_in_use( board_columns<Columns>() ); w++ )
+            {
+                old_tiles[t].word[w] = tiles[rows[t]].word[w];
+                old_guess_bits[t].word[w] = guess_bits[rows[t]].word[w];
+            }
+        }
+
+        if( check_this_clue_for<Columns>( clue ).valid )
+        {
+            ret = 1;
+            ProbeStep step = { slot, {} };
+            for( int t = 0; t < 3; t++ )
+            {
+                step.changed[t] = queue_changed_clues<Columns>( rows[t], old_tiles[t], old_guess_bits[t], queue );
+            }
+            if( trace )
+            {
+                trace->push_back( step );
+            }
+            w = 0;
+        }
     }
 
-    return 0;
+    return ret;
 }
 
-auto GameData::is_clue_compatible_one_side( Clue *clue ) -> int
+// propagate the queued clues, and with advanced set probe "what if" depth 1 (and search deeper in expert and
+// nightmare modes), until nothing new is found
+// returns 1 if any clue added new info
+auto GameData::solve_clues( uint64_t *queue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    return ( this->*solver->solve_clues )( queue );
+}
 
+template<int Columns, int Height>
+auto GameData::solve_clues_for( uint64_t *queue ) -> int
+{
+    DeepSearch search = {};
     int ret = 0;
+    do
+    { // repeat until no more information remains in clues
+        if( propagate_clues_for<Columns>( queue ) )
+        {
+            ret = 1;
+        }
+    } while( this->advanced && !cancelled()
+             && ( advanced_check_clues<Columns, Height>( queue ) // check "what if" depth 1
+                  || ( this->advanced >= EXPERT && deep_check_clues<Columns, Height>( queue, search ) ) ) );
+
+    return ret;
+}
+
+auto GameData::check_clues() -> int
+{
+    // check whether the clues add new info (within reason -- this can be tuned)
+    // for now it does not combine clues (analyze each one separately)
+    // if so, discover the info in tiles
+    // return 1 if new info was found, 0 if not
+    watch_clues();
+    ClueSet queue( clue_words );
+    for( int m = 0; m < clues.size(); m++ )
+    {
+        queue[m / 64] |= uint64_t( 1 ) << ( m % 64 );
+    }
+
+    return solve_clues( queue.data() );
+}
+
+auto GameData::cancelled() -> bool
+{
+    return progress && progress->cancel;
+}
+
+void GameData::create_game_with_clues()
+{
+    init_game();
+    create_puzzle();
+
+    using clock = std::chrono::steady_clock;
+    generation_times = {};
+
+    if( progress )
+    {
+        progress->clues = 0;
+        progress->solved = 0;
+        progress->filter_total = 0;
+        progress->filtered = 0;
+    }
+
+    // every clue rules out at least one tile, so this ends
+    clues.clear();
+    while( guessed < number_of_columns * column_height )
+    {
+        auto start = clock::now();
+        clues.push_back( {} );
+        do
+        {
+            get_clue( rand_int( number_of_columns ), rand_int( column_height ), &clues.back() );
+        } while( !check_this_clue( &clues.back() ).valid ); // should be while
+                                                            // !check_clues?
+        auto sampled = clock::now();
+        check_clues();
+        generation_times.sampling += std::chrono::duration<double>( sampled - start ).count();
+        generation_times.check += std::chrono::duration<double>( clock::now() - sampled ).count();
+        if( cancelled() )
+        {
+            return;
+        }
+        if( progress )
+        {
+            progress->clues = clues.size();
+            progress->solved = guessed;
+        }
+    }
+
+    if( !check_solution() )
+    { // debug
+        SPDLOG_ERROR( "ERROR: SOLUTION DOESN'T MATCH CLUES" );
+    }
 
-    for( int column = 0; column < number_of_columns; column++ )
+    auto start = clock::now();
+    filter_clues();
+    generation_times.filter = std::chrono::duration<double>( clock::now() - start ).count();
+    if( cancelled() )
     {
-        if( tiles[column][tile1.row][tile1.cell] && ( ret == -1 ) )
-        {
-            ret = 1;
-            break; // loop
-        }
+        return;
+    }
+    SPDLOG_INFO( "{}x{} game created with {} clues", number_of_columns, column_height, clues.size() );
+
+    // clean guesses and tiles
+    init_game();
 
-        if( tiles[column][tile0.row][tile0.cell] )
+    // reveal reveal clues and remove them from clue list
+    for( int i = 0; i < clues.size(); i++ )
+    {
+        auto &clue = clues[i];
+        if( clue.rel == REVEAL )
         {
-            ret = -1;
+            guess_tile( clue.tile[0] );
+            remove_clue( i );
+            i--;
         }
     }
-    if( ret != 1 )
+
+    // mark clues unhidden
+    for( auto &clue : clues )
     {
-        ret = 0;
+        clue.hidden = false;
     }
+    reset_hints();
 
-    return ret;
+    start = clock::now();
+    record_script();
+    generation_times.script = std::chrono::duration<double>( clock::now() - start ).count();
 }
 
-auto GameData::is_clue_compatible_together_2( Clue *clue ) -> int
+auto GameData::is_clue_compatible_reveal( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
-
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( tiles[column][tile0.row][tile0.cell] && tiles[column][tile1.row][tile1.cell] )
-        {
-            return 1;
-        }
-    }
+    auto tile0 = clue.tile( 0 );
 
-    return 0;
+    return has_tile( tile0.column, tile0.row, tile0.cell ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_together_3( Clue *clue ) -> int
+auto GameData::is_clue_compatible_one_side( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    for( int column = 0; column < number_of_columns; column++ )
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+
+    if( !mask0 )
     {
-        if( tiles[column][tile0.row][tile0.cell] && tiles[column][tile1.row][tile1.cell]
-            && tiles[column][tile2.row][tile2.cell] )
-        {
-            return 1;
-        }
+        return 0;
     }
 
-    return 0;
+    // some second strictly to the right of the leftmost first
+    unsigned first_left = mask0 & ( ~mask0 + 1 );
+    return ( mask1 & ~( ( first_left << 1 ) - 1 ) ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_together_not_middle( Clue *clue ) -> int
+auto GameData::is_clue_compatible_together_2( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( ( tiles[column][tile0.row][tile0.cell] ) && ( this->guess[column][tile1.row] != tile1.cell )
-            && tiles[column][tile2.row][tile2.cell] )
-        {
-            return 1;
-        }
-    }
+    return ( item_mask( tile0.row, tile0.cell ) & item_mask( tile1.row, tile1.cell ) ) ? 1 : 0;
+}
 
-    return 0;
+auto GameData::is_clue_compatible_together_3( PackedClue clue ) -> int
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
+
+    return ( item_mask( tile0.row, tile0.cell ) & item_mask( tile1.row, tile1.cell )
+             & item_mask( tile2.row, tile2.cell ) )
+               ? 1
+               : 0;
 }
 
-auto GameData::is_clue_compatible_not_together( Clue *clue ) -> int
+auto GameData::is_clue_compatible_together_not_middle( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( ( this->guess[column][tile0.row] != tile0.cell ) && tiles[column][tile1.row][tile1.cell] )
-        {
-            return 1;
-        }
-    }
+    return ( item_mask( tile0.row, tile0.cell ) & ~guessed_mask( tile1.row, tile1.cell )
+             & item_mask( tile2.row, tile2.cell ) )
+               ? 1
+               : 0;
+}
 
-    return 0;
+auto GameData::is_clue_compatible_not_together( PackedClue clue ) -> int
+{
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+
+    return ( ~guessed_mask( tile0.row, tile0.cell ) & item_mask( tile1.row, tile1.cell ) ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_next_to( Clue *clue ) -> int
+auto GameData::is_clue_compatible_next_to( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    for( int column = 0; column < number_of_columns - 1; column++ )
-    {
-        if( ( tiles[column][tile0.row][tile0.cell] && tiles[column + 1][tile1.row][tile1.cell] )
-            || ( tiles[column][tile1.row][tile1.cell] && tiles[column + 1][tile0.row][tile0.cell] ) )
-        {
-            return 1;
-        }
-    }
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
 
-    return 0;
+    return ( ( mask0 & ( mask1 >> 1 ) ) | ( mask1 & ( mask0 >> 1 ) ) ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_not_next_to( Clue *clue ) -> int
+auto GameData::is_clue_compatible_not_next_to( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
 
-    for( int column = 0; column < number_of_columns; column++ )
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+
+    for( ; mask0; mask0 &= mask0 - 1 )
     {
-        for( int row = 0; row < number_of_columns; row++ )
+        if( mask1 & ~neighbors( mask0 & ( ~mask0 + 1 ) ) )
         {
-            if( tiles[column][tile0.row][tile0.cell] && tiles[row][tile1.row][tile1.cell] )
-            {
-                if( ( column - row != 1 ) && ( row - column ) != 1 )
-                {
-                    return 1;
-                }
-            }
+            return 1;
         }
     }
 
     return 0;
 }
 
-auto GameData::is_clue_compatible_consecutive( Clue *clue ) -> int
+auto GameData::is_clue_compatible_consecutive( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    for( int column = 0; column < number_of_columns - 2; column++ )
-    {
-        if( ( tiles[column][tile0.row][tile0.cell] && tiles[column + 1][tile1.row][tile1.cell]
-              && tiles[column + 2][tile2.row][tile2.cell] )
-            || ( tiles[column][tile2.row][tile2.cell] && tiles[column + 1][tile1.row][tile1.cell]
-                 && tiles[column + 2][tile0.row][tile0.cell] ) )
-        {
-            return 1;
-        }
-    }
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
 
-    return 0;
+    return ( ( mask0 & ( mask1 >> 1 ) & ( mask2 >> 2 ) ) | ( mask2 & ( mask1 >> 1 ) & ( mask0 >> 2 ) ) ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_not_middle( Clue *clue ) -> int
+auto GameData::is_clue_compatible_not_middle( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
-    for( int column = 0; column < number_of_columns - 2; column++ )
-    {
-        if( ( tiles[column][tile0.row][tile0.cell] && ( this->guess[column + 1][tile1.row] != tile1.cell )
-              && tiles[column + 2][tile2.row][tile2.cell] )
-            || ( tiles[column][tile2.row][tile2.cell] && ( this->guess[column + 1][tile1.row] != tile1.cell )
-                 && tiles[column + 2][tile0.row][tile0.cell] ) )
-        {
-            return 1;
-        }
-    }
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned free1 = ~guessed_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
 
-    return 0;
+    return ( ( mask0 & ( free1 >> 1 ) & ( mask2 >> 2 ) ) | ( mask2 & ( free1 >> 1 ) & ( mask0 >> 2 ) ) ) ? 1 : 0;
 }
 
-auto GameData::is_clue_compatible_together_first_with_only_one( Clue *clue ) -> int
+auto GameData::is_clue_compatible_together_first_with_only_one( PackedClue clue ) -> int
 {
-    auto &tile0 = clue->tile[0];
-    auto &tile1 = clue->tile[1];
-    auto &tile2 = clue->tile[2];
+    auto tile0 = clue.tile( 0 );
+    auto tile1 = clue.tile( 1 );
+    auto tile2 = clue.tile( 2 );
 
     // xxx todo: check this:
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( tiles[column][tile0.row][tile0.cell]
-            && ( tiles[column][tile1.row][tile1.cell] || tiles[column][tile2.row][tile2.cell] )
-            && !( ( this->guess[column][tile1.row] == tile1.cell )
-                  && ( this->guess[column][tile2.row] == tile2.cell ) ) )
-        {
-            return 1;
-        }
-    }
+    unsigned mask0 = item_mask( tile0.row, tile0.cell );
+    unsigned mask1 = item_mask( tile1.row, tile1.cell );
+    unsigned mask2 = item_mask( tile2.row, tile2.cell );
+    unsigned both = guessed_mask( tile1.row, tile1.cell ) & guessed_mask( tile2.row, tile2.cell );
 
-    return 0;
+    return ( mask0 & ( mask1 | mask2 ) & ~both ) ? 1 : 0;
 }
 
 // checks if clue is compatible with current panel (not necessarily with solution)
-auto GameData::is_clue_compatible( Clue *clue ) -> int
+auto GameData::is_clue_compatible( PackedClue clue ) -> int
 {
-    switch( clue->rel )
+    switch( clue.rel() )
     {
         case REVEAL:
             return is_clue_compatible_reveal( clue );
@@ -1060,14 +1795,20 @@ auto GameData::is_clue_compatible( Clue *clue ) -> int
 
 auto GameData::check_panel_consistency() -> int
 {
-    for( int m = 0; m < clue_n; m++ )
+    return broken_clue() < 0 ? 1 : 0;
+}
+
+// by slot, so the clues of a relation are checked one after the other. needs an up to date clue_table
+auto GameData::broken_clue() -> int
+{
+    for( int slot = 0; slot < int( clue_table.clue.size() ); slot++ )
     {
-        if( !is_clue_compatible( &clues[m] ) )
+        if( !is_clue_compatible( clue_table.clue[slot] ) )
         {
-            return 0;
+            return slot;
         }
     }
-    return 1;
+    return -1;
 }
 
 auto GameData::check_panel_correctness() -> int
@@ -1076,7 +1817,7 @@ auto GameData::check_panel_correctness() -> int
     {
         for( int row = 0; row < column_height; row++ )
         {
-            if( !tiles[column][row][puzzle[column][row]] )
+            if( !has_tile( column, row, puzzle[column][row] ) )
             {
                 return 0;
             }
@@ -1085,30 +1826,94 @@ auto GameData::check_panel_correctness() -> int
     return 1;
 }
 
-auto GameData::check_clues_for_solution() -> int
+// only the moves of the player change the board outside a level, and a move changes one row, so the mistakes are
+// kept by row. a new mistake goes at the end of the list, one that is fixed leaves it
+void GameData::update_mistakes( int row )
 {
-    int info;
+    unsigned wrong = 0;
+    for( int column = 0; column < number_of_columns; column++ )
+    {
+        if( !has_tile( column, row, puzzle[column][row] ) )
+        {
+            wrong |= 1u << column;
+        }
+    }
 
-    init_game();
+    unsigned fixed = mistake_columns[row] & ~wrong;
+    if( fixed )
+    {
+        mistakes.erase( std::remove_if( mistakes.begin(),
+                                        mistakes.end(),
+                                        [&]( const TileAddress &tile ) {
+                                            return tile.row == row && ( ( fixed >> tile.column ) & 1 );
+                                        } ),
+                        mistakes.end() );
+    }
+    for( unsigned made = wrong & ~mistake_columns[row]; made; made &= made - 1 )
+    {
+        int column = bit_index( made );
+        mistakes.push_back( { column, row, puzzle[column][row] } );
+    }
+    mistake_columns[row] = wrong;
+}
 
-    do
-    { // repeat until no more information remains in clues
-        info = 0;
-        for( int m = 0; m < clue_n; m++ )
+void GameData::apply_move( TileAddress tile, MOVE_OP op )
+{
+    switch( op )
+    {
+        case MOVE_HIDE:
+            hide_tile_and_check( tile );
+            break;
+        case MOVE_GUESS:
+            guess_tile( tile );
+            break;
+        case MOVE_SHOW:
+            show_tile( tile );
+            break;
+        case MOVE_UNGUESS:
+            unguess_tile( tile.column, tile.row );
+            break;
+    }
+    update_mistakes( tile.row );
+}
+
+// a move changes one row, so setting the row undoes or redoes it. guessed changes by the blocks the row has guessed
+void GameData::restore_row( int row, const RowBits &old_tiles, const RowBits &old_guess_bits )
+{
+    guessed -= bit_count( any_columns( guess_bits[row], number_of_columns ) );
+    tiles[row] = old_tiles;
+    guess_bits[row] = old_guess_bits;
+    guessed += bit_count( any_columns( guess_bits[row], number_of_columns ) );
+
+    for( int column = 0; column < number_of_columns; column++ )
+    {
+        this->guess[column][row] = -1;
+    }
+    for( unsigned cells = any_cells( guess_bits[row], number_of_columns ); cells; cells &= cells - 1 )
+    {
+        int cell = bit_index( cells );
+        this->guess[bit_index( guess_bits[row].get( cell, lane_width() ) )][row] = cell;
+    }
+    update_mistakes( row );
+}
+
+void GameData::reset_mistakes()
+{
+    mistakes.clear();
+    for( int row = 0; row < MAX_ROWS; row++ )
+    {
+        mistake_columns[row] = 0;
+        if( row < column_height )
         {
-            if( check_this_clue( &clues[m] ).valid )
-            {
-                info = 1;
-            }
-        }
-        if( !info && this->advanced )
-        { // check "what if" depth 1
-            while( advanced_check_clues() )
-            {
-                info = 1;
-            }
+            update_mistakes( row );
         }
-    } while( info );
+    }
+}
+
+auto GameData::check_clues_for_solution() -> int
+{
+    init_game();
+    check_clues();
 
     if( guessed == number_of_columns * column_height )
     {
@@ -1120,10 +1925,113 @@ auto GameData::check_clues_for_solution() -> int
     }
 }
 
+// number of solutions of the clues from the current tiles, counted up to limit by a complete search.
+// unlike check_clues_for_solution it doesn't depend on how far the deductions go. the board is left as it was
+auto GameData::count_solutions( int limit ) -> int
+{
+    push_level();
+    watch_clues();
+    ClueSet queue( clue_words );
+    for( int m = 0; m < clues.size(); m++ )
+    {
+        queue[m / 64] |= uint64_t( 1 ) << ( m % 64 );
+    }
+    propagate_clues( queue.data() );
+    int count = search_solutions( limit );
+    pop_level();
+
+    return count;
+}
+
+// the clues are propagated: check for a dead end, then branch on the open block with the fewest tiles left
+auto GameData::search_solutions( int limit ) -> int
+{
+    return ( this->*solver->search_solutions )( limit );
+}
+
+template<int Columns, int Height>
+auto GameData::search_solutions_for( int limit ) -> int
+{
+    if( is_dead_end_for<Columns, Height>() )
+    {
+        return 0;
+    }
+
+    int column;
+    int row;
+    if( !fewest_tiles_block_for<Columns, Height>( &column, &row ) )
+    { // every block is guessed and every clue holds
+        return 1;
+    }
+
+    int count = 0;
+    for( unsigned cells = block_mask( column, row ); cells && count < limit; cells &= cells - 1 )
+    {
+        push_level();
+        propagate_guess<Columns>( { column, row, bit_index( cells ) } );
+        count += search_solutions_for<Columns, Height>( limit - count );
+        pop_level_for<Columns>();
+    }
+
+    return count;
+}
+
+// no solution can follow: a block without tiles, a tile without a block, or a clue that can't hold
+auto GameData::is_dead_end() -> int
+{
+    return ( this->*solver->is_dead_end )();
+}
+
+template<int Columns, int Height>
+auto GameData::is_dead_end_for() -> int
+{
+    unsigned columns = all_columns( board_columns<Columns>() );
+    for( int row = 0; row < board_height<Height>(); row++ )
+    {
+        if( ( any_columns( tiles[row], board_columns<Columns>() ) & columns ) != columns
+            || ( any_cells( tiles[row], board_columns<Columns>() ) & columns ) != columns )
+        {
+            return 1;
+        }
+    }
+
+    return check_panel_consistency() ? 0 : 1;
+}
+
+// the block that is not guessed and has the fewest tiles left. returns 0 if every block is guessed
+auto GameData::fewest_tiles_block( int *column, int *row ) -> int
+{
+    return ( this->*solver->fewest_tiles_block )( column, row );
+}
+
+template<int Columns, int Height>
+auto GameData::fewest_tiles_block_for( int *column, int *row ) -> int
+{
+    int best_n = board_columns<Columns>() + 1;
+    for( int j = 0; j < board_height<Height>(); j++ )
+    {
+        unsigned guessed_columns = any_columns( guess_bits[j], board_columns<Columns>() );
+        unsigned open = all_columns( board_columns<Columns>() ) & ~guessed_columns;
+        for( ; open; open &= open - 1 )
+        {
+            int i = bit_index( open );
+            int n = bit_count( column_cells( tiles[j], board_columns<Columns>(), i ) );
+            if( n < best_n )
+            {
+                *column = i;
+                *row = j;
+                best_n = n;
+            }
+        }
+    }
+
+    return best_n <= board_columns<Columns>() ? 1 : 0;
+}
+
 void GameData::join_clues()
 {
     // xxx todo: check this
-    for( int i = clue_n - 1; i > 0; i-- )
+    for( int i = clues.size() - 1; i > 0; i-- )
     {
         auto &clue = clues[i];
         if( clue.rel == TOGETHER_2 || clue.rel == NOT_TOGETHER )
@@ -1137,6 +2045,11 @@ void GameData::join_clues()
                         || ( ( clue2.tile[1].row == clue.tile[0].row )
                              && ( clue2.tile[1].cell == clue.tile[0].cell ) ) )
                     {
+                        if( clue2.rel == NOT_TOGETHER && clue2.tile[1].row == clue.tile[0].row
+                            && clue2.tile[1].cell == clue.tile[0].cell )
+                        { // the shared item goes first: it is the one together with the third
+                            std::swap( clue2.tile[0], clue2.tile[1] );
+                        }
                         clue2.tile[2].row = clue.tile[1].row;
                         clue2.tile[2].cell = clue.tile[1].cell;
                         clue2.rel = clue2.rel == TOGETHER_2 ? TOGETHER_3 : TOGETHER_NOT_MIDDLE;
@@ -1185,7 +2098,7 @@ void GameData::join_clues()
 
 void GameData::sort_clues()
 {
-    for( int i = 0; i < clue_n; i++ )
+    for( int i = 0; i < clues.size(); i++ )
     {
         auto &clue = clues[i];
         switch( clue.rel )
@@ -1223,29 +2136,100 @@ void GameData::sort_clues()
     }
 }
 
-auto GameData::filter_clues() -> int
+// append clues to the list and solve with them
+void GameData::add_clues( const std::vector<Clue> &more )
 {
-    int ret = 0;
+    int old_clue_n = clues.size();
+    for( auto &clue : more )
+    {
+        clues.push_back( clue );
+    }
+    watch_clues();
+    ClueSet queue( clue_words );
+    for( int slot = 0; slot < clues.size(); slot++ )
+    {
+        if( clue_table.index[slot] >= old_clue_n )
+        {
+            queue[slot / 64] |= uint64_t( 1 ) << ( slot % 64 );
+        }
+    }
+    solve_clues( queue.data() );
+}
+
+// the board has propagated all the clues: append the undecided clues that are needed on top of them to solve the
+// puzzle. a clue is tested with every other undecided clue present, so the board for the first half of the undecided
+// clues is built once with the second half, and the other way around; the trail undoes it. every test then starts
+// from a board where all the other clues have been propagated.
+void GameData::minimize_clues( const std::vector<Clue> &undecided )
+{
+    int total = number_of_columns * column_height;
+
+    if( cancelled() )
+    {
+        return;
+    }
 
-    for( int m = 0; m < clue_n; m++ )
-    { // test reduction
-        std::swap( clues[clue_n - 1], clues[m] );
-        init_game();
-        clue_n--;
-        if( check_clues_for_solution() )
+    if( guessed == total )
+    { // solved without them
+        if( progress )
         {
-            ret = 1;
+            progress->filtered += undecided.size();
         }
-        else
+        return;
+    }
+
+    if( undecided.size() == 1 )
+    { // the board is solved as far as the other clues go, so this one is needed
+        if( progress )
         {
-            clue_n++;
+            progress->filtered++;
         }
+        add_clues( undecided );
+        return;
+    }
+
+    size_t half = undecided.size() / 2;
+    std::vector<Clue> first( undecided.begin(), undecided.begin() + half );
+    std::vector<Clue> second( undecided.begin() + half, undecided.end() );
+    int base_n = clues.size();
+
+    push_level();
+    add_clues( second );
+    minimize_clues( first );
+    std::vector<Clue> needed( clues.begin() + base_n + second.size(), clues.end() );
+    pop_level();
+
+    clues.resize( base_n );
+    add_clues( needed );
+    minimize_clues( second );
+}
+
+// remove clues until every one left is needed to solve the puzzle
+auto GameData::filter_clues() -> int
+{
+    if( !check_clues_for_solution() )
+    {
+        return 0;
+    }
+
+    int old_clue_n = clues.size();
+    std::vector<Clue> undecided( clues.begin(), clues.end() );
+    if( progress )
+    {
+        progress->filter_total = clues.size();
+    }
+    init_game();
+    clues.clear();
+    minimize_clues( undecided );
+    if( cancelled() )
+    {
+        return 0;
     }
 
     join_clues();
     sort_clues();
 
-    return ret;
+    return clues.size() < old_clue_n ? 1 : 0;
 }
 
 auto GameData::get_random_tile( int column, int *row, int *cell ) -> int
@@ -1260,7 +2244,7 @@ auto GameData::get_random_tile( int column, int *row, int *cell ) -> int
         {
             if( this->guess[column][row2] < 0 )
             {
-                if( tiles[column][row2][cell2] )
+                if( has_tile( column, row2, cell2 ) )
                 {
                     m++;
                 }
@@ -1277,7 +2261,7 @@ auto GameData::get_random_tile( int column, int *row, int *cell ) -> int
     {
         for( cell2 = 0; cell2 < number_of_columns; cell2++ )
         {
-            if( tiles[column][row2][cell2] && ( this->guess[column][row2] < 0 ) )
+            if( has_tile( column, row2, cell2 ) && ( this->guess[column][row2] < 0 ) )
             {
                 m--;
                 if( m < 0 )
@@ -1298,8 +2282,15 @@ auto GameData::get_random_tile( int column, int *row, int *cell ) -> int
 
 auto GameData::random_relation() -> int
 {
+    // total of REL_PERCENT, summed here so that changes in the settings are always used
+    int rel_percent_max = 0;
+    for( int i = 0; i < NUMBER_OF_RELATIONS; i++ )
+    {
+        rel_percent_max += REL_PERCENT[i];
+    }
+
     int rel = -1;
-    int m = rand_int( REL_PERCENT_MAX );
+    int m = rand_int( rel_percent_max );
     int s = 0;
     for( int i = 0; i < NUMBER_OF_RELATIONS; i++ )
     {
@@ -1731,165 +2722,209 @@ void GameData::init_game()
         reset_rel_params();
     }
 
-    // initialize REL_PERCENT_MAX (total sum) for random relation creation
-    REL_PERCENT_MAX = 0;
-    for( int i = 0; i < NUMBER_OF_RELATIONS; i++ )
-    {
-        REL_PERCENT_MAX += REL_PERCENT[i];
-    }
-
-    for( int column = 0; column < number_of_columns; column++ )
+    for( int row = 0; row < MAX_ROWS; row++ )
     {
-        for( int row = 0; row < column_height; row++ )
+        tiles[row] = {};
+        guess_bits[row] = {};
+        for( int cell = 0; cell < number_of_columns && row < column_height; cell++ )
+        {
+            tiles[row].show( cell, all_columns( number_of_columns ), lane_width() );
+        }
+        for( int column = 0; column < number_of_columns; column++ )
         {
             this->guess[column][row] = -1;
             this->tile_col[row][column] = -1;
-            for( int cell = 0; cell < number_of_columns; cell++ )
-            {
-                tiles[column][row][cell] = 1;
-            }
         }
     }
     guessed = 0;
+    memset( mistake_columns, 0, sizeof( mistake_columns ) );
+    mistakes.clear();
+
+    select_solver();
 }
 
-// return -1 if there is more than one tile left in block
-// last tile number otherwise
-auto GameData::last_tile_in_block( int column, int row ) -> int
+template<int Columns, int Height>
+static auto solver_for() -> const SolverKernels *
 {
-    int m = -1;
-    int count = 0;
+    static const SolverKernels kernels = { &GameData::pop_level_for<Columns>,
+                                           &GameData::propagate_clues_for<Columns>,
+                                           &GameData::check_this_clue_for<Columns>,
+                                           &GameData::is_dead_end_for<Columns, Height>,
+                                           &GameData::fewest_tiles_block_for<Columns, Height>,
+                                           &GameData::solve_clues_for<Columns, Height>,
+                                           &GameData::search_solutions_for<Columns, Height>,
+                                           &GameData::probe_tile<Columns> };
+    return &kernels;
+}
+
+void GameData::select_solver()
+{
+    using SolverFor = auto ( * )() -> const SolverKernels *;
+    static const SolverFor sizes[5][5] = {
+        { solver_for<4, 4>, solver_for<4, 5>, solver_for<4, 6>, solver_for<4, 7>, solver_for<4, 8> },
+        { solver_for<5, 4>, solver_for<5, 5>, solver_for<5, 6>, solver_for<5, 7>, solver_for<5, 8> },
+        { solver_for<6, 4>, solver_for<6, 5>, solver_for<6, 6>, solver_for<6, 7>, solver_for<6, 8> },
+        { solver_for<7, 4>, solver_for<7, 5>, solver_for<7, 6>, solver_for<7, 7>, solver_for<7, 8> },
+        { solver_for<8, 4>, solver_for<8, 5>, solver_for<8, 6>, solver_for<8, 7>, solver_for<8, 8> } };
 
-    if( this->guess[column][row] >= 0 )
+    if( number_of_columns >= 4 && number_of_columns <= 8 && column_height >= 4 && column_height <= 8 )
     {
-        return -1;
+        solver = sizes[number_of_columns - 4][column_height - 4]();
     }
-
-    for( int cell = 0; cell < number_of_columns; cell++ )
-    { // find if there is only 1 tile left
-        if( tiles[column][row][cell] )
-        {
-            m = cell;
-            count++;
-        }
-        if( count > 1 )
-        {
-            return -1;
-        }
+    else
+    {
+        solver = solver_for<0, 0>();
     }
-    return m;
 }
 
-// return -1 if there is more than one block with given tile
-// last block number (column) otherwise
-auto GameData::last_tile_in_row( int row, int cell ) -> int
+template<int Columns>
+auto GameData::board_columns() -> int
 {
-    int m = -1;
-    int count = 0;
+    return Columns ? Columns : number_of_columns;
+}
 
-    for( int column = 0; column < number_of_columns; column++ )
-    { // find if there is only 1 tile left
-        if( this->guess[column][row] == cell )
-        {
-            return -1;
-        }
-        if( tiles[column][row][cell] )
-        {
-            m = column;
-            count++;
-        }
-        if( count > 1 )
-        {
-            return -1;
-        }
-    }
-    return m;
+template<int Height>
+auto GameData::board_height() -> int
+{
+    return Height ? Height : column_height;
+}
+
+template<int Columns>
+auto GameData::board_lane() -> int
+{
+    return lane_bits( board_columns<Columns>() );
+}
+
+auto GameData::has_tile( int column, int row, int cell ) -> bool
+{
+    return ( tiles[row].get( cell, lane_width() ) >> column ) & 1;
+}
+
+void GameData::show_tile( TileAddress tile )
+{
+    save_row( tile.row );
+    tiles[tile.row].show( tile.cell, 1u << tile.column, lane_width() );
+}
+
+auto GameData::block_mask( int column, int row ) -> unsigned
+{
+    return column_cells( tiles[row], number_of_columns, column );
+}
+
+auto GameData::item_mask( int row, int cell ) -> unsigned
+{
+    return tiles[row].get( cell, lane_width() );
+}
+
+auto GameData::guessed_mask( int row, int cell ) -> unsigned
+{
+    return guess_bits[row].get( cell, lane_width() );
 }
 
 // check any obviously guessable clues in row
 auto GameData::check_row( int row ) -> int
 {
-    int m;
-
-    for( int column = 0; column < number_of_columns; column++ )
-    { // find if there is only 1 tile left
-        m = last_tile_in_block( column, row );
-        if( m >= 0 )
-        {
-            guess_tile( { column, row, m } );
-            return 1;
-        }
+    // a block with only 1 tile left
+    unsigned once;
+    unsigned twice;
+    count_columns( tiles[row], number_of_columns, &once, &twice );
+    unsigned singles = once & ~twice & ~any_columns( guess_bits[row], number_of_columns );
+    if( singles )
+    {
+        int column = bit_index( singles );
+        guess_tile( { column, row, bit_index( block_mask( column, row ) ) } );
+        return 1;
     }
 
-    for( int cell = 0; cell < number_of_columns; cell++ )
+    // a tile left in only 1 block
+    singles = single_cells( tiles[row], number_of_columns ) & ~any_cells( guess_bits[row], number_of_columns );
+    if( singles )
     {
-        m = last_tile_in_row( row, cell ); // check if there is only 1 left of this tile
-        if( m >= 0 )
-        {
-            guess_tile( { m, row, cell } );
-            return 1;
-        }
+        int cell = bit_index( singles );
+        guess_tile( { bit_index( tiles[row].get( cell, lane_width() ) ), row, cell } );
+        return 1;
     }
     return 0;
 }
 
 void GameData::hide_tile_and_check( TileAddress tile )
 {
-    tiles[tile.column][tile.row][tile.cell] = 0;
+    save_row( tile.row );
+    tiles[tile.row].hide( tile.cell, 1u << tile.column, lane_width() );
     check_row( tile.row );
 }
 
 void GameData::guess_tile( TileAddress tile )
 {
+    int lane = lane_width();
+    uint64_t block = lane_low( number_of_columns ) << tile.column;
+    unsigned bit = 1u << tile.column;
+    unsigned keep = tiles[tile.row].get( tile.cell, lane ) & bit;
+
+    save_row( tile.row );
     this->guess[tile.column][tile.row] = tile.cell;
-    guessed++;
-    for( int m = 0; m < number_of_columns; m++ )
-    {
-        if( m != tile.cell )
-        {
-            tiles[tile.column][tile.row][m] = 0; // hide all tiles from this block
-        }
-    }
 
-    for( int m = 0; m < number_of_columns; m++ )
+    // hide all tiles from this block and this tile in all blocks
+    for( int w = 0; w < words_in_use( number_of_columns ); w++ )
     {
-        if( m != tile.column )
-        {
-            tiles[m][tile.row][tile.cell] = 0; // hide this tile in all blocks
-        }
+        guess_bits[tile.row].word[w] &= ~block;
+        tiles[tile.row].word[w] &= ~block;
     }
+    guess_bits[tile.row].show( tile.cell, bit, lane );
+    tiles[tile.row].hide( tile.cell, all_columns( lane ), lane );
+    tiles[tile.row].show( tile.cell, keep, lane );
+    guessed++;
 
     check_row( tile.row );
 }
 
 auto GameData::is_guessed( int row, int cell ) -> int
 {
-    for( int column = 0; column < number_of_columns; column++ )
-    {
-        if( this->guess[column][row] == cell )
-        {
-            return 1;
-        }
-    }
-
-    return 0;
+    return guessed_mask( row, cell ) ? 1 : 0;
 }
 
 void GameData::unguess_tile( int column, int row )
 {
     int cell = this->guess[column][row];
+    save_row( row );
     this->guess[column][row] = -1;
+    guess_bits[row].hide( cell, 1u << column, lane_width() );
     guessed--;
 
-    for( int m = 0; m < number_of_columns; m++ )
+    // bring back the tiles that are not guessed elsewhere, in the blocks that are not guessed
+    unsigned free_cells = all_columns( number_of_columns ) & ~any_cells( guess_bits[row], number_of_columns );
+    unsigned free_columns = all_columns( number_of_columns ) & ~any_columns( guess_bits[row], number_of_columns );
+
+    for( unsigned cells = free_cells; cells; cells &= cells - 1 )
     {
-        if( !is_guessed( row, m ) )
-        {
-            tiles[column][row][m] = 1;
-        }
-        if( this->guess[m][row] < 0 )
+        tiles[row].show( bit_index( cells ), 1u << column, lane_width() );
+    }
+    tiles[row].show( cell, free_columns, lane_width() );
+}
+
+// rebuild guesses from the blocks that have a single tile left
+void GameData::update_guessed()
+{
+    guessed = 0;
+
+    for( int row = 0; row < column_height; row++ )
+    {
+        unsigned once;
+        unsigned twice;
+        count_columns( tiles[row], number_of_columns, &once, &twice );
+        guess_bits[row] = {};
+        for( int column = 0; column < number_of_columns; column++ )
         {
-            tiles[m][row][cell] = 1;
+            if( ( ( once & ~twice ) >> column ) & 1 )
+            {
+                this->guess[column][row] = bit_index( block_mask( column, row ) );
+                guess_bits[row].show( this->guess[column][row], 1u << column, lane_width() );
+                guessed++;
+            }
+            else
+            {
+                this->guess[column][row] = -1;
+            }
         }
     }
 }
@@ -2011,3 +3046,393 @@ auto GameData::is_clue_valid( Clue *clue ) -> int
     }
     return ret;
 }
+
+// Save files
+// little endian, with no padding:
+//   "WTSN", the version, the flags, number_of_columns, column_height and advanced, a byte each
+//   time in ms, 4 bytes
+//   puzzle row by row, two cells a byte
+//   the number of clues in 2 bytes, then 6 bytes a clue: the PackedClue bits, and hidden in bit 40
+//   for every row and cell the columns where the tile is still available, (number_of_columns + 7) / 8 bytes
+//   the number of "what if" steps of the script still open in 2 bytes, then their tile_index, 2 bytes each
+//   CRC-32 of all the bytes before it, 4 bytes
+// no flag is defined yet: they are for additions an older reader can't skip, so a file with one it doesn't know is
+// refused. the files of the versions before this format were the GameData fields as they were in memory, see
+// read_legacy_save
+constexpr uint8_t SAVE_MAGIC[4] = { 'W', 'T', 'S', 'N' };
+constexpr int SAVE_VERSION = 2;
+constexpr unsigned SAVE_FLAGS = 0; // every flag this version knows
+constexpr uint64_t PACKED_CLUE_BITS = ( uint64_t( 1 ) << 40 ) - 1;
+
+static auto crc32( const uint8_t *data, size_t size ) -> uint32_t
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for( size_t i = 0; i < size; i++ )
+    {
+        crc ^= data[i];
+        for( int bit = 0; bit < 8; bit++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( crc & 1 ) ) );
+        }
+    }
+    return ~crc;
+}
+
+static void put_bytes( std::vector<uint8_t> &out, uint64_t value, int bytes )
+{
+    for( int i = 0; i < bytes; i++ )
+    {
+        out.push_back( uint8_t( value >> ( 8 * i ) ) );
+    }
+}
+
+struct SaveReader // reads a save file front to back. reading past the end clears ok and gives 0
+{
+    const uint8_t *data;
+    size_t size;
+    size_t at;
+    bool ok;
+
+    auto get( int bytes ) -> uint64_t
+    {
+        if( size - at < size_t( bytes ) )
+        {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for( int i = 0; i < bytes; i++ )
+        {
+            value |= uint64_t( data[at++] ) << ( 8 * i );
+        }
+        return value;
+    }
+};
+
+// a save file, read and checked, before it goes into the game
+struct SavedGame
+{
+    int columns;
+    int height;
+    int level; // -1 when the file doesn't say
+    double seconds;
+    int cells[MAX_COLUMNS][MAX_ROWS];
+    std::vector<Clue> clues;
+    RowBits board[MAX_ROWS];
+    std::vector<ScriptStep> script;
+};
+
+auto GameData::save_game() -> std::vector<uint8_t>
+{
+    std::vector<uint8_t> out( SAVE_MAGIC, SAVE_MAGIC + 4 );
+    put_bytes( out, SAVE_VERSION, 1 );
+    put_bytes( out, 0, 1 ); // flags
+    put_bytes( out, number_of_columns, 1 );
+    put_bytes( out, column_height, 1 );
+    put_bytes( out, advanced, 1 );
+    put_bytes( out, uint32_t( time * 1000 ), 4 );
+
+    for( int row = 0; row < column_height; row++ )
+    {
+        for( int column = 0; column < number_of_columns; column += 2 )
+        {
+            int high = column + 1 < number_of_columns ? puzzle[column + 1][row] : 0;
+            put_bytes( out, puzzle[column][row] | ( high << 4 ), 1 );
+        }
+    }
+
+    put_bytes( out, clues.size(), 2 );
+    for( auto &clue : clues )
+    {
+        put_bytes( out, PackedClue( clue ).bits | ( uint64_t( clue.hidden ) << 40 ), 6 );
+    }
+
+    int mask_bytes = ( number_of_columns + 7 ) / 8;
+    for( int row = 0; row < column_height; row++ )
+    {
+        for( int cell = 0; cell < number_of_columns; cell++ )
+        {
+            put_bytes( out, tiles[row].get( cell, lane_width() ), mask_bytes );
+        }
+    }
+
+    // the steps done on the board are skipped by get_hint, so they need not be kept
+    std::vector<int> open;
+    for( auto &step : script )
+    {
+        if( has_tile( step.column, step.row, step.cell ) )
+        {
+            open.push_back( tile_index( { step.column, step.row, step.cell } ) );
+        }
+    }
+    put_bytes( out, open.size(), 2 );
+    for( int index : open )
+    {
+        put_bytes( out, index, 2 );
+    }
+
+    put_bytes( out, crc32( out.data(), out.size() ), 4 );
+    return out;
+}
+
+static auto read_save( const std::vector<uint8_t> &data, SavedGame &saved ) -> bool
+{
+    SaveReader crc = { data.data(), data.size(), data.size() - 4, true };
+    if( crc32( data.data(), data.size() - 4 ) != crc.get( 4 ) )
+    {
+        return false;
+    }
+    SaveReader in = { data.data(), data.size() - 4, 4, true };
+
+    int version = in.get( 1 );
+    unsigned flags = in.get( 1 );
+    saved.columns = in.get( 1 );
+    saved.height = in.get( 1 );
+    saved.level = in.get( 1 );
+    saved.seconds = in.get( 4 ) / 1000.0;
+    if( version != SAVE_VERSION || ( flags & ~SAVE_FLAGS ) || saved.columns < 1 || saved.columns > MAX_COLUMNS
+        || saved.height < 1 || saved.height > MAX_ROWS || saved.level >= NUMBER_OF_DIFFICULTIES )
+    {
+        return false;
+    }
+    int columns = saved.columns;
+    int height = saved.height;
+
+    for( int row = 0; row < height; row++ )
+    {
+        unsigned seen = 0;
+        for( int column = 0; column < columns; column += 2 )
+        {
+            int pair = in.get( 1 );
+            saved.cells[column][row] = pair & 0xF;
+            seen |= 1u << ( pair & 0xF );
+            if( column + 1 < columns )
+            {
+                saved.cells[column + 1][row] = pair >> 4;
+                seen |= 1u << ( pair >> 4 );
+            }
+            else if( pair >> 4 )
+            {
+                return false;
+            }
+        }
+        if( seen != all_columns( columns ) )
+        { // not one of each item
+            return false;
+        }
+    }
+
+    saved.clues.resize( in.get( 2 ) );
+    for( auto &clue : saved.clues )
+    {
+        uint64_t bits = in.get( 6 );
+        PackedClue packed;
+        packed.bits = bits & PACKED_CLUE_BITS;
+        if( ( bits >> 41 ) || packed.rel() >= NUMBER_OF_RELATIONS )
+        {
+            return false;
+        }
+        clue = {};
+        clue.rel = packed.rel();
+        clue.hidden = ( bits >> 40 ) & 1;
+        for( int m = 0; m < 3; m++ )
+        {
+            clue.tile[m] = packed.tile( m );
+            if( clue.tile[m].column >= columns || clue.tile[m].row >= height || clue.tile[m].cell >= columns )
+            {
+                return false;
+            }
+        }
+    }
+
+    int mask_bytes = ( columns + 7 ) / 8;
+    for( int row = 0; row < height; row++ )
+    {
+        for( int cell = 0; cell < columns; cell++ )
+        {
+            unsigned mask = in.get( mask_bytes );
+            if( mask & ~all_columns( columns ) )
+            {
+                return false;
+            }
+            saved.board[row].show( cell, mask, lane_bits( columns ) );
+        }
+    }
+
+    saved.script.resize( in.get( 2 ) );
+    for( auto &step : saved.script )
+    {
+        int index = in.get( 2 );
+        TileAddress tile = tile_at( index );
+        if( index >= MAX_ROWS * MAX_COLUMNS * MAX_CELLS || tile.column >= columns || tile.row >= height
+            || tile.cell >= columns )
+        {
+            return false;
+        }
+        step = { uint8_t( tile.column ), uint8_t( tile.row ), uint8_t( tile.cell ) };
+    }
+    return in.ok && in.at == in.size;
+}
+
+// the save file of the versions before SAVE_VERSION: number_of_columns, column_height, puzzle[8][8],
+// clue_n, clues[100], tiles[8][8][8] and time, each written as it was in memory. an int is 4 bytes, and a clue
+// 60: three tiles of a valid byte padded to 4 and three ints, then rel, index, hidden and padding. there is no level
+// and no script
+constexpr int LEGACY_SIZE = 8;
+constexpr int LEGACY_CLUES = 100;
+constexpr size_t LEGACY_CLUE_BYTES = 60;
+constexpr size_t LEGACY_SAVE_BYTES = 4 + 4 + 4 * LEGACY_SIZE * LEGACY_SIZE + 4 + LEGACY_CLUES * LEGACY_CLUE_BYTES
+                                     + 4 * LEGACY_SIZE * LEGACY_SIZE * LEGACY_SIZE + 8;
+
+static auto read_legacy_save( const std::vector<uint8_t> &data, SavedGame &saved ) -> bool
+{
+    if( data.size() != LEGACY_SAVE_BYTES )
+    {
+        return false;
+    }
+    SaveReader in = { data.data(), data.size(), 0, true };
+    auto get_int = [&in]() { return int( int32_t( in.get( 4 ) ) ); };
+
+    saved.columns = get_int();
+    saved.height = get_int();
+    saved.level = -1;
+    int columns = saved.columns;
+    int height = saved.height;
+    if( columns < 1 || columns > LEGACY_SIZE || height < 1 || height > LEGACY_SIZE )
+    {
+        return false;
+    }
+
+    for( int column = 0; column < LEGACY_SIZE; column++ )
+    {
+        for( int row = 0; row < LEGACY_SIZE; row++ )
+        {
+            int cell = get_int();
+            if( column < columns && row < height )
+            {
+                if( cell < 0 || cell >= columns )
+                {
+                    return false;
+                }
+                saved.cells[column][row] = cell;
+            }
+        }
+    }
+    for( int row = 0; row < height; row++ )
+    {
+        unsigned seen = 0;
+        for( int column = 0; column < columns; column++ )
+        {
+            seen |= 1u << saved.cells[column][row];
+        }
+        if( seen != all_columns( columns ) )
+        {
+            return false;
+        }
+    }
+
+    int clue_n = get_int();
+    if( clue_n < 0 || clue_n > LEGACY_CLUES )
+    {
+        return false;
+    }
+    saved.clues.resize( clue_n );
+    for( int i = 0; i < LEGACY_CLUES; i++ )
+    {
+        Clue clue = {};
+        for( auto &tile : clue.tile )
+        {
+            in.get( 4 ); // valid
+            tile.column = get_int();
+            tile.row = get_int();
+            tile.cell = get_int();
+        }
+        int rel = get_int();
+        in.get( 4 ); // index
+        int hidden = in.get( 4 ) & 0xFF;
+        if( i >= clue_n )
+        {
+            continue;
+        }
+        if( rel < 0 || rel >= NUMBER_OF_RELATIONS || hidden > 1 )
+        {
+            return false;
+        }
+        for( auto &tile : clue.tile )
+        {
+            if( tile.column < 0 || tile.column >= columns || tile.row < 0 || tile.row >= height || tile.cell < 0
+                || tile.cell >= columns )
+            {
+                return false;
+            }
+        }
+        clue.rel = RELATION( rel );
+        clue.hidden = hidden;
+        saved.clues[i] = clue;
+    }
+
+    for( int column = 0; column < LEGACY_SIZE; column++ )
+    {
+        for( int row = 0; row < LEGACY_SIZE; row++ )
+        {
+            for( int cell = 0; cell < LEGACY_SIZE; cell++ )
+            {
+                if( get_int() && column < columns && row < height && cell < columns )
+                {
+                    saved.board[row].show( cell, 1u << column, lane_bits( columns ) );
+                }
+            }
+        }
+    }
+
+    uint64_t time_bits = in.get( 8 );
+    memcpy( &saved.seconds, &time_bits, sizeof( saved.seconds ) );
+    return in.ok && saved.seconds >= 0 && saved.seconds < 1e9;
+}
+
+// the game is only changed once the whole file checks out: the header, every field in range, the size and the CRC.
+// a file from before this format is read once through read_legacy_save, and saved in this one the next time.
+// returns false for anything else, newer versions included
+auto GameData::load_game( const std::vector<uint8_t> &data ) -> bool
+{
+    SavedGame saved = {};
+    if( data.size() >= 4 + 9 + 4 && std::equal( SAVE_MAGIC, SAVE_MAGIC + 4, data.begin() ) )
+    {
+        if( !read_save( data, saved ) )
+        {
+            return false;
+        }
+    }
+    else if( !read_legacy_save( data, saved ) )
+    {
+        return false;
+    }
+
+    number_of_columns = saved.columns;
+    column_height = saved.height;
+    if( saved.level >= 0 )
+    {
+        advanced = saved.level;
+    }
+    time = saved.seconds;
+    for( int column = 0; column < saved.columns; column++ )
+    {
+        for( int row = 0; row < saved.height; row++ )
+        {
+            puzzle[column][row] = saved.cells[column][row];
+        }
+    }
+    clues.clear();
+    for( auto &clue : saved.clues )
+    {
+        clues.push_back( clue );
+    }
+    std::copy( saved.board, saved.board + MAX_ROWS, tiles );
+    script = saved.script;
+
+    update_guessed();
+    reset_mistakes();
+    select_solver();
+    reset_hints();
+    return true;
+}
@@ -1,7 +1,17 @@
 #pragma once
 
-#include "tiled_block.hpp"
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "macros.hpp"
+#include "small_vector.hpp"
+
+constexpr int MAX_COLUMNS = 16; // largest board
+constexpr int MAX_ROWS = 16;
+constexpr int MAX_CELLS = MAX_COLUMNS; // a row has as many items as the board has columns
 
 // Structures
 enum class HOLD_CLICK_CHECK
@@ -48,6 +58,15 @@ enum RELATION
     NUMBER_OF_RELATIONS
 };
 
+enum DIFFICULTY // GameData::advanced, every level also uses the deductions of the ones before
+{
+    BASIC = 0,
+    ADVANCED,  // "what if" depth 1
+    EXPERT,    // rule out a tile when guessing it leaves a block with no option one guess further
+    NIGHTMARE, // rule out a tile when a search finds no solution with it, within a node budget
+    NUMBER_OF_DIFFICULTIES
+};
+
 struct TileAddress
 {
     bool valid;
@@ -65,11 +84,22 @@ struct Hint
     bool valid;
     int clue_number;
     TileAddress tile;
+    std::vector<int> chain; // what if hints: the clues from guessing tile to a contradiction, clue_number last
 
     Hint() : valid( false ), clue_number( 0 ), tile() { }
     Hint( bool valid_, int cn, TileAddress t ) : valid( valid_ ), clue_number( cn ), tile( t ) { }
 };
 
+// a step of the deduction script of a puzzle: a "what if" probe or a search rules out the tile (column, row, cell).
+// the steps are in the order the solver found them, from the board the player starts with. what a single clue rules
+// out in between is left to get_hint
+struct ScriptStep
+{
+    uint8_t column;
+    uint8_t row;
+    uint8_t cell;
+};
+
 struct Clue
 {
     // the three tiles from the clue are j[m], k[m] for m=0,1,2
@@ -81,34 +111,234 @@ struct Clue
     bool hidden;
 };
 
+// a clue as the solver kernels read it, in 8 bytes: the relation in bits 0-3, then 12 bits for each tile, with its
+// row, cell and column (in the solution) in 4 bits each
+struct PackedClue
+{
+    uint64_t bits;
+
+    PackedClue() : bits( 0 ) { }
+    explicit PackedClue( const Clue &clue ) : bits( clue.rel )
+    {
+        for( int m = 0; m < 3; m++ )
+        {
+            unsigned fields = clue.tile[m].row | ( clue.tile[m].cell << 4 ) | ( clue.tile[m].column << 8 );
+            bits |= uint64_t( fields ) << ( 4 + 12 * m );
+        }
+    }
+
+    auto rel() const -> RELATION { return RELATION( bits & 0xF ); }
+    auto tile( int m ) const -> TileAddress
+    {
+        unsigned fields = unsigned( bits >> ( 4 + 12 * m ) );
+        return { int( ( fields >> 8 ) & 0xF ), int( fields & 0xF ), int( ( fields >> 4 ) & 0xF ) };
+    }
+};
+static_assert( MAX_COLUMNS <= 16 && MAX_ROWS <= 16, "PackedClue has 4 bits for a row, cell or column" );
+
+// xoshiro256** generator: fast, and the same sequence on every platform for a given seed
+struct Rng
+{
+    uint64_t state[4];
+
+    Rng() { seed( 0 ); }
+
+    void seed( uint64_t seed ); // fill the state from a splitmix64 sequence
+    auto next() -> uint64_t;
+    auto uniform( int n ) -> int; // unbiased in [0, n)
+};
+
+// bits of a RowBits lane on a board of number_of_columns: 8 up to 8 columns, so that a row is one word, 16 above
+constexpr auto lane_bits( int number_of_columns ) -> int
+{
+    return number_of_columns <= 8 ? 8 : 16;
+}
+
+// one row of the board: lane [cell] (lane_bits wide, 64 / lane_bits to a word) holds the columns where the item can
+// still be, as a bit mask. lanes past the board stay 0, so whole words can be worked on at once
+struct RowBits
+{
+    uint64_t word[MAX_CELLS / 4];
+
+    auto get( int cell, int lane ) const -> unsigned
+    {
+        return unsigned( word[cell * lane / 64] >> ( cell * lane % 64 ) ) & ( ( 1u << lane ) - 1 );
+    }
+    void show( int cell, unsigned columns, int lane )
+    {
+        word[cell * lane / 64] |= uint64_t( columns ) << ( cell * lane % 64 );
+    }
+    void hide( int cell, unsigned columns, int lane )
+    {
+        word[cell * lane / 64] &= ~( uint64_t( columns ) << ( cell * lane % 64 ) );
+    }
+    void flip( int cell, unsigned columns, int lane )
+    {
+        word[cell * lane / 64] ^= uint64_t( columns ) << ( cell * lane % 64 );
+    }
+};
+
+struct TrailEntry
+{
+    int row;
+    RowBits tiles;      // GameData::tiles[row] before the first change in the level
+    RowBits guess_bits; // GameData::guess_bits[row] before the first change in the level
+};
+
+struct TrailLevel
+{
+    size_t trail_size;   // trail entries made before the level
+    int guessed;         // GameData::guessed before the level
+    unsigned saved_rows; // rows already stored in the trail for this level
+};
+
+struct GenerationTimes // seconds spent in each step of create_game_with_clues
+{
+    double sampling; // picking random clues that add information
+    double check;    // check_clues after every new clue
+    double filter;   // filter_clues
+    double script;   // record_script
+};
+
+struct GenerationProgress // create_game_with_clues reports here, and stops early once cancel is set (any thread)
+{
+    std::atomic<int> clues;        // clues placed
+    std::atomic<int> solved;       // cells solved with them
+    std::atomic<int> filter_total; // clues to filter, 0 until filter_clues starts
+    std::atomic<int> filtered;     // clues kept or dropped by filter_clues so far
+    std::atomic<bool> cancel;
+};
+
+struct Nogood // tiles that can't all be in the solution
+{
+    std::vector<int> tiles; // tile_index of each
+};
+
+using GuessSet = std::bitset<MAX_COLUMNS * MAX_ROWS>; // positions in DeepSearch::path, a path has one guess per block
+
+struct DeepSearch // refutation search of the expert and nightmare levels
+{
+    int max_depth;                       // guesses on a path, the tile being ruled out included
+    long budget;                         // nodes to rule out one tile
+    long nodes;                          // spent on the current tile
+    long pass_nodes;                     // spent in the current deep_check_clues, bounded by PASS_BUDGET
+    RowBits root_tiles[MAX_ROWS];        // board the guesses start from
+    RowBits root_guess_bits[MAX_ROWS];   // of the same board
+    std::vector<TileAddress> path;       // guesses, the tile being ruled out first
+    RowBits path_tiles[MAX_ROWS];        // the same guesses, as a board
+    RowBits solution_tiles[MAX_ROWS];    // tiles of the solutions found on the way, they can't be ruled out
+    std::vector<Nogood> nogoods;         // learned from the dead ends, valid while the clues don't change
+    std::vector<std::vector<int>> nogoods_with; // [tile_index] nogoods that have the tile, sized by the first one
+};
+
+using ClueList = SmallVector<Clue, 64>;    // a puzzle up to 8x8 keeps its clues in place
+using ClueSet = SmallVector<uint64_t, 8>; // one bit per clue slot, GameData::clue_words words
+
+// the clues packed for the solver, grouped by relation: a pass over the clues runs through one relation after the
+// other on contiguous data. the clue queues and watch lists are by slot. built by watch_clues
+struct ClueTable
+{
+    std::vector<PackedClue> clue;       // [slot]
+    std::vector<int> index;             // [slot] the clue in GameData::clues
+    int first[NUMBER_OF_RELATIONS + 1]; // the slots of relation rel are first[rel] .. first[rel + 1] - 1
+};
+
+// what every clue rules out next on the board the player sees, so a hint is a lookup. update_hints works it out
+// again only for the clues that mention an item that changed since the last update. the game only reads it
+// through get_hint for now, marking the clues that have something to say on the panel is left for later
+struct HintCache
+{
+    std::vector<TileAddress> next; // [clue] the tile it rules out next, not valid if the clue has nothing left to say
+    std::vector<int> cost;         // [clue] how hard that deduction is for the player, see hint_cost
+    RowBits tiles[MAX_ROWS];       // the board next is for
+    RowBits guess_bits[MAX_ROWS];
+    bool ready = false; // next is for the current clues. cleared by reset_hints
+};
+
+// a clue that added new info while a "what if" probe propagated, see GameData::probe_tile
+struct ProbeStep
+{
+    int slot;
+    unsigned changed[3]; // [t] the cells of row clue.tile( t ).row that changed
+};
+
+enum MOVE_OP : uint8_t // what the player did to a tile
+{
+    MOVE_HIDE,
+    MOVE_GUESS,
+    MOVE_SHOW,
+    MOVE_UNGUESS, // the tile is the one guessed in its block
+};
+
+struct SolverKernels; // the solver hot paths compiled for one board size, see GameData::select_solver
+
 struct GameData
 {
-    int guess[8][8];    // guessed value for guess[column][row] = cell;
-    int puzzle[8][8];   // [col][block] = [tile]
-    int tiles[8][8][8]; // [col][block][tile]
-    Clue clues[MAX_CLUES];
-    int clue_n;
+    int guess[MAX_COLUMNS][MAX_ROWS];  // guessed value for guess[column][row] = cell;
+    int puzzle[MAX_COLUMNS][MAX_ROWS]; // [col][block] = [tile]
+    RowBits tiles[MAX_ROWS];           // [row][cell] columns where the tile is still available
+    RowBits guess_bits[MAX_ROWS];      // [row][cell] column where the tile is guessed, if any
+    ClueList clues;
     int number_of_columns; // number of columns
     int column_height;     // column height
     double time;
     int guessed;
-    int tile_col[8][8]; // column where puzzle tile [row][tile] is located (in solution);
-    int where[8][8];
+    int tile_col[MAX_ROWS][MAX_CELLS]; // column where puzzle tile [row][tile] is located (in solution);
+    int where[MAX_ROWS][MAX_CELLS];
     int advanced;
+    int threads; // worker threads for the "what if" probes, 0 uses every core
+    Rng rng;     // puzzle generation, seed it to reproduce a puzzle
+    GenerationTimes generation_times; // of the last create_game_with_clues
+    GenerationProgress *progress;      // nullptr, or where create_game_with_clues reports
+    ClueTable clue_table;             // clues, as the solver reads them
+    int clue_words;                   // words in a ClueSet, for the clues in clue_table
+    std::vector<uint64_t> clue_watch; // [row][cell][word] slots of the clues that mention the item, see watchers
+    std::vector<TrailEntry> trail;         // rows changed since the oldest open level
+    std::vector<TrailLevel> trail_levels;  // open levels, innermost last
+    const SolverKernels *solver;           // for number_of_columns x column_height, set by select_solver
+    HintCache hint_cache;
+    std::vector<ScriptStep> script; // how the puzzle is solved, see record_script
+    unsigned mistake_columns[MAX_ROWS]; // [row] columns where the player ruled out the tile of the solution
+    std::vector<TileAddress> mistakes;  // the same tiles, in the order they were ruled out
 
     void init_game(); // clean board and guesses xxx todo: add clues?
-    void switch_game( int type );
-    auto advanced_check_clues() -> int;
+    void select_solver(); // pick the solver instance for the board size, before solving a new or loaded board
+    void push_level(); // start recording changes to the board
+    void pop_level();  // undo the changes made since the matching push_level
+    void save_row( int row );
+    void learn_nogood( DeepSearch &search, const GuessSet &conflict );
     void create_game_with_clues();
+    auto cancelled() -> bool; // progress->cancel is set, the puzzle is left unfinished
     void create_puzzle();
     auto get_hint() -> Hint;
+    auto get_what_if_hint() -> Hint; // needs update_hints
+    void record_script();
+    void record_removed( const RowBits before[] );
+    auto script_hint( const ScriptStep &step ) -> Hint;
+    auto contradiction_chain( const std::vector<ProbeStep> &trace ) -> std::vector<int>;
+    void reset_hints();  // the clues changed: work out every hint again at the next update_hints
+    void update_hints(); // bring the hints up to date with the board, after the player's moves
+    auto hint_cost( int rel ) -> int; // of the deduction made with a clue of rel since the last push_level
     auto check_solution() -> int;
     auto check_panel_consistency() -> int;
+    auto broken_clue() -> int; // slot of the first clue the panel contradicts, -1 if none
     auto check_panel_correctness() -> int;
+    void update_mistakes( int row ); // after the player changed row: a move, or an undo
+    void apply_move( TileAddress tile, MOVE_OP op ); // as the player does it, with its mistakes
+    void restore_row( int row, const RowBits &old_tiles, const RowBits &old_guess_bits ); // undo or redo a move
+    void reset_mistakes();           // work the mistakes out again from the whole board, after loading one
+    auto save_game() -> std::vector<uint8_t>;             // the puzzle and the board, in the save file format
+    auto load_game( const std::vector<uint8_t> &data ) -> bool; // false, and the game unchanged, if data is not valid
     void guess_tile( TileAddress tile );
     void hide_tile_and_check( TileAddress tile );
     void unguess_tile( int i, int j );
     auto is_guessed( int j, int k ) -> int; // is the value k on row j guessed?
+    void update_guessed();                  // rebuild guesses from the blocks that have a single tile left
+    auto has_tile( int column, int row, int cell ) -> bool;
+    void show_tile( TileAddress tile );
+    auto block_mask( int column, int row ) -> unsigned;  // cells still available in block
+    auto item_mask( int row, int cell ) -> unsigned;     // columns where tile is still available
+    auto guessed_mask( int row, int cell ) -> unsigned;  // columns where tile is guessed
     void get_clue( int i, int j, Clue *clue );
 
     void remove_clue( int i );
@@ -116,6 +346,9 @@ struct GameData
     auto filter_clues() -> int;
     void sort_clues();
 
+    auto rand_int( int n ) -> int;
+    auto rand_sign() -> int;
+    void shuffle( int p[], int n );
     auto get_random_tile( int column, int *row, int *cell ) -> int;
     auto random_relation() -> int;
     void get_random_item_col( int column, int *row, int *cell );
@@ -135,41 +368,96 @@ struct GameData
 
     auto check_clues() -> int;
     auto check_clues_for_solution() -> int;
+    auto count_solutions( int limit ) -> int;
+    auto search_solutions( int limit ) -> int;
+    auto is_dead_end() -> int;
+    auto fewest_tiles_block( int *column, int *row ) -> int;
+    void watch_clues();
+    auto lane_width() const -> int { return lane_bits( number_of_columns ); } // of the rows in tiles and guess_bits
+    auto watchers( int row, int cell ) -> uint64_t * // clue_words words in clue_watch
+    {
+        return clue_watch.data() + ( row * number_of_columns + cell ) * clue_words;
+    }
+    auto propagate_clues( uint64_t *queue, std::vector<ProbeStep> *trace = nullptr ) -> int;
+    auto solve_clues( uint64_t *queue ) -> int;
+    void add_clues( const std::vector<Clue> &more );
+    void minimize_clues( const std::vector<Clue> &undecided );
     auto check_this_clue( Clue *clue ) -> TileAddress;
-    auto check_this_clue_reveal( Clue *clue ) -> TileAddress;
-    auto check_this_clue_one_side( Clue *clue ) -> TileAddress;
-    auto check_this_clue_together_2( Clue *clue ) -> TileAddress;
-    auto check_this_clue_together_3( Clue *clue ) -> TileAddress;
-    auto check_this_clue_together_not_middle( Clue *clue ) -> TileAddress;
-    auto check_this_clue_not_together( Clue *clue ) -> TileAddress;
-    auto check_this_clue_next_to( Clue *clue ) -> TileAddress;
-    auto check_this_clue_not_next_to( Clue *clue ) -> TileAddress;
-    auto check_this_clue_consecutive( Clue *clue ) -> TileAddress;
-    auto check_this_clue_not_middle( Clue *clue ) -> TileAddress;
-    auto check_this_clue_together_first_with_only_one( Clue *clue ) -> TileAddress;
-
-    auto last_tile_in_block( int column, int row ) -> int;
-    auto last_tile_in_row( int row, int cell ) -> int;
+    auto check_this_clue_reveal( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_one_side( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_together_2( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_together_3( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_together_not_middle( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_not_together( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_next_to( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_not_next_to( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_consecutive( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_not_middle( PackedClue clue ) -> TileAddress;
+    auto check_this_clue_together_first_with_only_one( PackedClue clue ) -> TileAddress;
+
+    auto hide_clue_tiles( PackedClue clue, const unsigned hide[3] ) -> TileAddress;
+
+    // the solver hot paths for boards of Columns x Height, 0 for a size only known at run time
+    template<int Columns>
+    auto board_columns() -> int;
+    template<int Height>
+    auto board_height() -> int;
+    template<int Columns>
+    auto board_lane() -> int; // lane_bits of the board
+    template<int Columns>
+    void pop_level_for();
+    template<int Columns>
+    auto queue_changed_clues( int row,
+                              const RowBits &old_tiles,
+                              const RowBits &old_guess_bits,
+                              uint64_t *queue ) -> unsigned;
+    template<int Columns>
+    auto propagate_clues_for( uint64_t *queue, std::vector<ProbeStep> *trace = nullptr ) -> int;
+    template<int Columns>
+    void propagate_guess( TileAddress tile, std::vector<ProbeStep> *trace = nullptr );
+    template<int Columns>
+    auto probe_tile( TileAddress tile, std::vector<ProbeStep> *trace ) -> int;
+    template<int Columns>
+    auto check_this_clue_for( PackedClue clue ) -> TileAddress;
+    template<int Columns>
+    auto check_this_clue_one_side_for( PackedClue clue ) -> TileAddress;
+    template<int Columns>
+    auto check_this_clue_consecutive_for( PackedClue clue ) -> TileAddress;
+    template<int Columns, int Height>
+    auto solve_clues_for( uint64_t *queue ) -> int;
+    template<int Columns, int Height>
+    auto advanced_check_clues( uint64_t *queue ) -> int;
+    template<int Columns, int Height>
+    auto deep_check_clues( uint64_t *queue, DeepSearch &search ) -> int;
+    template<int Columns, int Height>
+    auto refute( DeepSearch &search, GuessSet &conflict ) -> int;
+    template<int Columns, int Height>
+    auto replay_is_dead_end( DeepSearch &search, const GuessSet &guesses ) -> int;
+    template<int Columns, int Height>
+    auto search_solutions_for( int limit ) -> int;
+    template<int Columns, int Height>
+    auto is_dead_end_for() -> int;
+    template<int Columns, int Height>
+    auto fewest_tiles_block_for( int *column, int *row ) -> int;
     auto check_row( int row ) -> int;
 
     // debug
     auto is_clue_valid( Clue *clue ) -> int;
 
-    auto is_clue_compatible( Clue *clue ) -> int;
-    auto is_clue_compatible_reveal( Clue *clue ) -> int;
-    auto is_clue_compatible_one_side( Clue *clue ) -> int;
-    auto is_clue_compatible_together_2( Clue *clue ) -> int;
-    auto is_clue_compatible_together_3( Clue *clue ) -> int;
-    auto is_clue_compatible_together_not_middle( Clue *clue ) -> int;
-    auto is_clue_compatible_not_together( Clue *clue ) -> int;
-    auto is_clue_compatible_next_to( Clue *clue ) -> int;
-    auto is_clue_compatible_not_next_to( Clue *clue ) -> int;
-    auto is_clue_compatible_consecutive( Clue *clue ) -> int;
-    auto is_clue_compatible_not_middle( Clue *clue ) -> int;
-    auto is_clue_compatible_together_first_with_only_one( Clue *clue ) -> int;
-};
-
-void shuffle( int p[], int n );
+    auto is_clue_compatible( PackedClue clue ) -> int;
+    auto is_clue_compatible_reveal( PackedClue clue ) -> int;
+    auto is_clue_compatible_one_side( PackedClue clue ) -> int;
+    auto is_clue_compatible_together_2( PackedClue clue ) -> int;
+    auto is_clue_compatible_together_3( PackedClue clue ) -> int;
+    auto is_clue_compatible_together_not_middle( PackedClue clue ) -> int;
+    auto is_clue_compatible_not_together( PackedClue clue ) -> int;
+    auto is_clue_compatible_next_to( PackedClue clue ) -> int;
+    auto is_clue_compatible_not_next_to( PackedClue clue ) -> int;
+    auto is_clue_compatible_consecutive( PackedClue clue ) -> int;
+    auto is_clue_compatible_not_middle( PackedClue clue ) -> int;
+    auto is_clue_compatible_together_first_with_only_one( PackedClue clue ) -> int;
+};
+
 auto is_vclue( RELATION rel ) -> int; // is this relation a vertical clue?
 void reset_rel_params();
 
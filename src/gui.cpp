@@ -3,6 +3,7 @@
 #include "gui.hpp"
 
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <algorithm>
 
@@ -33,8 +34,8 @@ const char ABOUT_TEXT[] =
     "binary releases can be found at https://github.com/nuritanrikut/Watson"
     "\n"
     "\n"
-    "Note: the \"extra hard\" mode generates (much) harder puzzles, which require indirect logic and hasn't been "
-    "properly tested.\n";
+    "Note: the advanced, expert and nightmare levels generate (much) harder puzzles, which require indirect logic "
+    "and thinking ahead many steps.\n";
 
 const char HELP_TEXT[] =
     "Watson is a puzzle similar to the classic \"Zebra puzzle\" or \"Einstein's Riddle\". The goal is to figure out "
@@ -53,11 +54,13 @@ const char HELP_TEXT[] =
     "\n"
     "There is an undo button avialable. Go to settings to switch the tileset and other additional options."
     "\n"
-    "Keyboard shortcuts: R to start again, ESC to quit, U to undo, C to get a hint, T to switch tiles. You can resize "
-    "the window or press F to go fullscreen.\n"
+    "Keyboard shortcuts: R to start again, ESC to quit, U to undo, Y to redo, C to get a hint, T to switch "
+    "tiles. You can resize the window or press F to go fullscreen.\n"
     "\n"
     "DEBUG: S: show/hide solution.\n";
 
+const char *const DIFFICULTY_NAMES[NUMBER_OF_DIFFICULTIES] = { "Basic", "Advanced", "Expert", "Nightmare" };
+
 constexpr double GUI_XFACTOR = 0.5;
 constexpr double GUI_YFACTOR = 0.5;
 
@@ -75,6 +78,8 @@ enum
     BUTTON_TILES,
     GROUP_COLS,
     GROUP_ROWS,
+    GROUP_LEVEL,
+    BUTTON_LEVEL,
     BUTTON_SAVE,
     BUTTON_LOAD,
     BUTTON_ZOOM,
@@ -85,7 +90,6 @@ enum
     BUTTON_EXIT_NOW,
     BUTTON_LOAD_NOW,
     BUTTON_RESTART_NOW,
-    BUTTON_EXTRA_HARD,
     BUTTON_RESET_PARAMS,
     GUI_SETTINGS,
     GUI_PARAMS,
@@ -444,7 +448,7 @@ auto Gui::create_settings_gui() -> WZ_WIDGET *
     // scale other elements by font height
     auto fh = [gui_font_h = gui_font_h]( float scale ) { return scale * gui_font_h; };
 
-    int gui_h = fh( 7 * 2.5 ); // 7 rows * 2.5 height each
+    int gui_h = fh( 8 * 2.5 ); // 8 rows * 2.5 height each
 
     settings_new = settings_current;
 
@@ -459,8 +463,16 @@ auto Gui::create_settings_gui() -> WZ_WIDGET *
     but_sw = std::max( al_get_text_width( skin_theme->font, "Zoom" ), but_sw );
     but_sw += fh( 1 );
 
+    int level_w = 0;
+    for( auto *name : DIFFICULTY_NAMES )
+    {
+        level_w = std::max( al_get_text_width( skin_theme->font, name ), level_w );
+    }
+    level_w += fh( 1 );
+
     auto gui_w = fh( 20 );
     gui_w = std::max( gui_w, 3 * but_w + fh( 6 ) );
+    gui_w = std::max( gui_w, NUMBER_OF_DIFFICULTIES * level_w + fh( 10 ) );
 
     // main gui
     WZ_WIDGET *gui = nullptr;
@@ -507,6 +519,7 @@ auto Gui::create_settings_gui() -> WZ_WIDGET *
         }
 
         // number of rows multitoggle
+        // the solver takes boards up to MAX_ROWS x MAX_COLUMNS, but the tile artwork has only 8 items per row
         {
             auto y = fh( 2.5 ) * ( rn++ );
             create_fill_layout( x, y, w, h, fh( 1 ), 0, WZ_ALIGN_CENTRE, WZ_ALIGN_CENTRE );
@@ -548,6 +561,26 @@ auto Gui::create_settings_gui() -> WZ_WIDGET *
             }
         }
 
+        // level multitoggle
+        {
+            auto y = fh( 2.5 ) * ( rn++ );
+            create_fill_layout( x, y, w, h, fh( 1 ), 0, WZ_ALIGN_CENTRE, WZ_ALIGN_CENTRE );
+            {
+                auto str_width = al_get_text_width( skin_theme->font, "Columns: " );
+                auto str = al_ustr_new( "Level:" );
+                new WZ_TEXTBOX( gui, 0, 0, str_width, but_h, WZ_ALIGN_RIGHT, WZ_ALIGN_CENTRE, str, 1, -1 );
+            }
+            for( int i = 0; i < NUMBER_OF_DIFFICULTIES; i++ )
+            {
+                auto str = al_ustr_new( DIFFICULTY_NAMES[i] );
+                auto *wgt = new WZ_TOGGLE( gui, 0, 0, level_w, but_h, str, 1, GROUP_LEVEL, BUTTON_LEVEL );
+                if( i == settings_current.difficulty )
+                {
+                    wgt->down = 1;
+                }
+            }
+        }
+
         // sound + swtich tiles + zoom
         {
             auto y = fh( 2.5 ) * ( rn++ );
@@ -565,11 +598,11 @@ auto Gui::create_settings_gui() -> WZ_WIDGET *
             }
         }
 
-        // advanced + save + load buttons
+        // parameters + save + load buttons
         {
             auto y = fh( 2.5 ) * ( rn++ );
             create_fill_layout( x, y, w, h, fh( 1 ), 0, WZ_ALIGN_CENTRE, WZ_ALIGN_CENTRE );
-            new WZ_BUTTON( gui, 0, 0, but_w, but_h, al_ustr_new( "Advanced" ), 1, BUTTON_PARAMS );
+            new WZ_BUTTON( gui, 0, 0, but_w, but_h, al_ustr_new( "Parameters" ), 1, BUTTON_PARAMS );
             new WZ_BUTTON( gui, 0, 0, but_w, but_h, al_ustr_new( "Save game" ), 1, BUTTON_SAVE );
             {
                 auto *wgt = new WZ_TOGGLE( gui, 0, 0, but_w, but_h, al_ustr_new( "Load game" ), 1, -1, BUTTON_LOAD );
@@ -609,7 +642,7 @@ void Gui::create_win_gui_high_scores( double time, WZ_WIDGET *gui, int gui_w )
 
     get_highscores( settings_current.number_of_columns,
                     settings_current.column_height,
-                    settings_current.advanced,
+                    settings_current.difficulty,
                     hi_name,
                     (double *)hi_score );
 
@@ -861,7 +894,7 @@ auto Gui::create_params_gui() -> WZ_WIDGET *
         }
     }
 
-    int but_w = al_get_text_width( gui_font, "Extra hard" ) + fh( 2 );
+    int but_w = al_get_text_width( gui_font, "Cancel" ) + fh( 2 );
 
     // buttons
 
@@ -881,11 +914,6 @@ auto Gui::create_params_gui() -> WZ_WIDGET *
         auto w = but_w;
         auto h = fh( 1.5 );
 
-        {
-            auto *wgt = new WZ_TOGGLE( gui, x, y, w, h, al_ustr_new( "Extra hard" ), 1, -1, BUTTON_EXTRA_HARD );
-            wgt->down = settings_new.advanced ? 1 : 0;
-        }
-
         new WZ_BUTTON( gui, x, y, w, h, al_ustr_new( "Reset" ), 1, BUTTON_RESET_PARAMS );
         new WZ_BUTTON( gui, x, y, w, h, al_ustr_new( "OK" ), 1, BUTTON_OK );
 
@@ -955,7 +983,7 @@ void Gui::confirm_restart( Settings *new_set )
     auto str = al_ustr_newf( "Start new %dx%d%s game?",
                              settings_new.number_of_columns,
                              settings_new.column_height,
-                             settings_new.advanced ? " advanced" : "" );
+                             difficulty_word( settings_new.difficulty ) );
     auto gui = create_yesno_gui( -1, BUTTON_RESTART_NOW, BUTTON_CLOSE, str );
 
     add_gui( base_gui, gui );
@@ -1019,7 +1047,7 @@ void Gui::handle_gui_event_text_changed( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, W
     wgt->flags |= WZ_STATE_NOTWANT_FOCUS;
     save_highscores( settings_current.number_of_columns,
                      settings_current.column_height,
-                     settings_current.advanced,
+                     settings_current.difficulty,
                      hi_name,
                      hi_score );
     remove_gui( gui );
@@ -1078,7 +1106,7 @@ void Gui::handle_gui_event_settings( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, WZ_WI
         case BUTTON_OK:
             if( ( settings_new.number_of_columns != settings_current.number_of_columns )
                 || ( settings_new.column_height != settings_current.column_height )
-                || ( settings_new.advanced != settings_current.advanced ) )
+                || ( settings_new.difficulty != settings_current.difficulty ) )
             {
                 confirm_restart( &settings_new );
             }
@@ -1152,6 +1180,16 @@ void Gui::handle_gui_event_settings( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, WZ_WI
         case BUTTON_COLS:
             settings_new.number_of_columns = atoi( al_cstr( ( (WZ_BUTTON *)wgt )->text ) );
             break;
+
+        case BUTTON_LEVEL:
+            for( int i = 0; i < NUMBER_OF_DIFFICULTIES; i++ )
+            {
+                if( !strcmp( al_cstr( ( (WZ_BUTTON *)wgt )->text ), DIFFICULTY_NAMES[i] ) )
+                {
+                    settings_new.difficulty = DIFFICULTY( i );
+                }
+            }
+            break;
     }
 }
 
@@ -1162,11 +1200,7 @@ void Gui::handle_gui_event_params( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, WZ_WIDG
         return;
     }
 
-    if( wgt->id == BUTTON_EXTRA_HARD )
-    {
-        settings_new.advanced = !settings_new.advanced;
-    }
-    else if( wgt->id == BUTTON_OK )
+    if( wgt->id == BUTTON_OK )
     {
         wgt = gui->first_child;
         while( wgt )
@@ -1179,12 +1213,8 @@ void Gui::handle_gui_event_params( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, WZ_WIDG
         }
 
         ALLEGRO_USTR *msg =
-            al_ustr_newf( "WARNING: The puzzle generation parameters are here for debug purposes and altering "
-                          "them may make the game unbalanced. You can reset these settings later.\n\n%s",
-                          settings_new.advanced ? "You also turned on extra hard mode. This mode is not recommended. "
-                                                  "Puzzle generation will be slower, and solving the puzzles may "
-                                                  "require thinking ahead many steps and very indirect reasoning."
-                                                : "" );
+            al_ustr_new( "WARNING: The puzzle generation parameters are here for debug purposes and altering "
+                         "them may make the game unbalanced. You can reset these settings later." );
         remove_gui( gui );
         add_gui( base_gui, create_msg_gui( -1, msg ) );
     }
@@ -1192,19 +1222,14 @@ void Gui::handle_gui_event_params( ALLEGRO_EVENT *event, WZ_WIDGET *wgt, WZ_WIDG
     {
         wgt = gui->first_child;
         reset_rel_params();
-        settings_new.advanced = settings_current.advanced = false;
 
-        // update sliders and button
+        // update sliders
         while( wgt )
         {
             if( wgt->id >= 1024 ) // is slider
             {
                 ( (WZ_SCROLL *)wgt )->cur_pos = REL_PERCENT[wgt->id - 1024];
             }
-            else if( wgt->id == BUTTON_EXTRA_HARD )
-            {
-                ( (WZ_BUTTON *)wgt )->down = 0;
-            }
 
             wgt = wgt->next_sib;
         }
@@ -34,12 +34,6 @@
 
 #pragma endregion
 
-#pragma region game play related
-
-#define MAX_CLUES 100
-
-#pragma endregion
-
 #pragma region colors
 
 #define NULL_COLOR ( al_map_rgba_f( 0, 0, 0, 0 ) )
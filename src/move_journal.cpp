@@ -0,0 +1,85 @@
+#include "move_journal.hpp"
+
+#include <algorithm>
+
+void MoveJournal::clear()
+{
+    changes_end = 0;
+    end = 0;
+    done = 0;
+    undone = 0;
+}
+
+void MoveJournal::play( GameData &game_data, TileAddress tile, MOVE_OP op )
+{
+    RowBits old_tiles = game_data.tiles[tile.row];
+    RowBits old_guess_bits = game_data.guess_bits[tile.row];
+    game_data.apply_move( tile, op );
+
+    auto &move = moves[end];
+    move = { uint8_t( tile.row ), 0, changes_end };
+    int lane = game_data.lane_width();
+    for( int cell = 0; cell < game_data.number_of_columns; cell++ )
+    {
+        unsigned tiles = old_tiles.get( cell, lane ) ^ game_data.tiles[tile.row].get( cell, lane );
+        unsigned guess_bits = old_guess_bits.get( cell, lane ) ^ game_data.guess_bits[tile.row].get( cell, lane );
+        if( tiles || guess_bits )
+        {
+            changes[changes_end++ % JOURNAL_CHANGES] = { uint8_t( cell ), uint16_t( tiles ), uint16_t( guess_bits ) };
+            move.count++;
+        }
+    }
+
+    end = ( end + 1 ) % JOURNAL_MOVES;
+    done = std::min( done + 1, JOURNAL_MOVES );
+    undone = 0;
+
+    // forget the moves whose changes were written over
+    while( done && changes_end - moves[( end + JOURNAL_MOVES - done ) % JOURNAL_MOVES].first > JOURNAL_CHANGES )
+    {
+        done--;
+    }
+}
+
+// flipping the changed columns back and forth turns the row into what it was before or after the move
+void MoveJournal::flip( GameData &game_data, const Move &move )
+{
+    RowBits tiles = game_data.tiles[move.row];
+    RowBits guess_bits = game_data.guess_bits[move.row];
+    int lane = game_data.lane_width();
+    for( uint32_t i = move.first; i < move.first + move.count; i++ )
+    {
+        auto &change = changes[i % JOURNAL_CHANGES];
+        tiles.flip( change.cell, change.tiles, lane );
+        guess_bits.flip( change.cell, change.guess_bits, lane );
+    }
+    game_data.restore_row( move.row, tiles, guess_bits );
+}
+
+auto MoveJournal::undo( GameData &game_data ) -> bool
+{
+    if( !done )
+    {
+        return false;
+    }
+
+    end = ( end + JOURNAL_MOVES - 1 ) % JOURNAL_MOVES;
+    done--;
+    undone++;
+    flip( game_data, moves[end] );
+    return true;
+}
+
+auto MoveJournal::redo( GameData &game_data ) -> bool
+{
+    if( !undone )
+    {
+        return false;
+    }
+
+    flip( game_data, moves[end] );
+    end = ( end + 1 ) % JOURNAL_MOVES;
+    done++;
+    undone--;
+    return true;
+}
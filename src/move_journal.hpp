@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "game_data.hpp"
+
+constexpr int JOURNAL_MOVES = 256;    // moves that can be undone, the older ones are forgotten
+constexpr int JOURNAL_CHANGES = 1024; // changed cells kept for them, a move changes at most MAX_CELLS
+
+struct CellChange // the columns that a move flipped in one cell of its row
+{
+    uint8_t cell;
+    uint16_t tiles;      // GameData::tiles[row][cell] before xor after
+    uint16_t guess_bits; // same for GameData::guess_bits
+};
+
+struct Move // a move of the player: the cells of row it changed are changes[first] .. changes[first + count - 1]
+{
+    uint8_t row;
+    uint8_t count;
+    uint32_t first; // counts every change ever kept, the ring slot is first % JOURNAL_CHANGES
+};
+
+// the moves of the player for undo and redo, in a ring: the moves done end at end, the ones undone follow it until
+// a new move drops them. a move keeps only what it flipped, so undo and redo are the same xor. when the changes
+// wrap around, the oldest moves are forgotten
+struct MoveJournal
+{
+    std::array<Move, JOURNAL_MOVES> moves;
+    std::array<CellChange, JOURNAL_CHANGES> changes;
+    uint32_t changes_end = 0; // changes kept so far
+    int end = 0;              // slot after the last move done
+    int done = 0;             // moves before end that can be undone
+    int undone = 0;           // moves from end on that can be redone
+
+    void clear();
+    void play( GameData &game_data, TileAddress tile, MOVE_OP op );
+    auto undo( GameData &game_data ) -> bool; // false if there is nothing to undo
+    auto redo( GameData &game_data ) -> bool; // false if there is nothing to redo
+
+private:
+    void flip( GameData &game_data, const Move &move );
+};
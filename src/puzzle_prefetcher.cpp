@@ -0,0 +1,130 @@
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+
+#include "puzzle_prefetcher.hpp"
+
+#include <spdlog/spdlog.h>
+
+PuzzlePrefetcher::PuzzlePrefetcher() : ready( nullptr ), wanted( -1 ), quit( false ), progress(), work( nullptr )
+{
+}
+
+PuzzlePrefetcher::~PuzzlePrefetcher()
+{
+    stop();
+}
+
+void PuzzlePrefetcher::start( uint64_t seed )
+{
+    if( thread.joinable() )
+    {
+        return;
+    }
+
+    work = new GameData();
+    work->rng.seed( seed );
+    work->progress = &progress;
+    quit = false;
+    thread = std::thread( &PuzzlePrefetcher::run, this );
+}
+
+void PuzzlePrefetcher::stop()
+{
+    if( !thread.joinable() )
+    {
+        return;
+    }
+
+    quit = true;
+    progress.cancel = true;
+    wake();
+    thread.join();
+
+    delete ready.exchange( nullptr );
+    delete work;
+    work = nullptr;
+}
+
+void PuzzlePrefetcher::request( int number_of_columns, int column_height, int advanced )
+{
+    int key = pack( number_of_columns, column_height, advanced );
+    if( wanted.exchange( key ) != key )
+    {
+        progress.cancel = true;
+        wake();
+    }
+}
+
+auto PuzzlePrefetcher::take() -> GameData *
+{
+    GameData *puzzle = ready.exchange( nullptr );
+    if( !puzzle )
+    {
+        return nullptr;
+    }
+
+    wake(); // start the next one
+
+    if( pack( puzzle->number_of_columns, puzzle->column_height, puzzle->advanced ) != wanted )
+    { // made for settings that changed since
+        delete puzzle;
+        return nullptr;
+    }
+
+    return puzzle;
+}
+
+void PuzzlePrefetcher::wake()
+{
+    {
+        // taking the lock makes sure the thread is either asleep or will see the change before sleeping
+        std::lock_guard<std::mutex> lock( sleep_mutex );
+    }
+    sleep_cond.notify_one();
+}
+
+void PuzzlePrefetcher::run()
+{
+    int ready_key = -1; // pack() of the puzzle in ready, only meaningful while ready is set
+
+    auto has_work = [&]() { return wanted >= 0 && ( !ready || ready_key != wanted ); };
+
+    while( !quit )
+    {
+        {
+            std::unique_lock<std::mutex> lock( sleep_mutex );
+            sleep_cond.wait( lock, [&]() { return quit || has_work(); } );
+        }
+
+        // clear cancel before reading quit and the settings, so a stop or request made from now on cancels this puzzle
+        progress.cancel = false;
+        if( quit )
+        {
+            break;
+        }
+        int key = wanted;
+        if( ready && ready_key != key )
+        { // settings changed, the ready puzzle won't be taken
+            delete ready.exchange( nullptr );
+        }
+
+        work->number_of_columns = key & 0xff;
+        work->column_height = ( key >> 8 ) & 0xff;
+        work->advanced = key >> 16;
+        work->create_game_with_clues();
+
+        if( key != wanted || work->cancelled() )
+        { // settings changed while generating
+            continue;
+        }
+
+        SPDLOG_DEBUG( "Prefetched {}x{} puzzle.", work->number_of_columns, work->column_height );
+
+        auto *next = new GameData();
+        next->rng = work->rng;
+        next->progress = &progress;
+        work->progress = nullptr;
+        ready_key = key;
+        ready = work; // ready is empty: only this thread fills it
+        work = next;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "game_data.hpp"
+
+// keeps the next puzzle ready in a background thread, so a new game doesn't wait for create_game_with_clues
+//
+// the finished puzzle is handed to the caller through an atomic pointer; the mutex only puts the thread to sleep
+// while the puzzle waits to be taken.
+class PuzzlePrefetcher
+{
+public:
+    PuzzlePrefetcher();
+    ~PuzzlePrefetcher();
+
+    void start( uint64_t seed );
+    void stop();
+
+    // the size and mode of the puzzle to keep ready. a ready puzzle of another size or mode is thrown away, and one
+    // being generated is cancelled
+    void request( int number_of_columns, int column_height, int advanced );
+
+    // the ready puzzle of the requested size and mode, or nullptr if it isn't finished yet.
+    // the caller owns the puzzle, and the next one is started right away
+    auto take() -> GameData *;
+
+    // of the puzzle being generated
+    auto get_progress() -> const GenerationProgress & { return progress; }
+
+private:
+    void run();
+    void wake();
+
+    static auto pack( int number_of_columns, int column_height, int advanced ) -> int
+    {
+        return number_of_columns | column_height << 8 | advanced << 16;
+    }
+
+    std::atomic<GameData *> ready; // finished puzzle, waiting to be taken
+    std::atomic<int> wanted;       // pack() of the requested size and mode, -1 before the first request
+    std::atomic<bool> quit;
+    GenerationProgress progress;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cond;
+    std::thread thread;
+    GameData *work; // puzzle being generated, only touched by the thread
+};
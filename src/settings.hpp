@@ -1,12 +1,14 @@
 #pragma once
 
+#include "game_data.hpp"
+
 struct Settings
 {
     Settings()
     {
         number_of_columns = 5;
         column_height = 5;
-        advanced = false;
+        difficulty = BASIC;
         sound_mute = false;
         type_of_tiles = 0;
         fat_fingers = false;
@@ -16,10 +18,17 @@ struct Settings
 
     int number_of_columns;
     int column_height;
-    bool advanced;
+    DIFFICULTY difficulty;
     bool sound_mute;
     int type_of_tiles;
     bool fat_fingers; // todo: implement zoom of tiledblocks for small screens
     int restart;
     bool saved; // is there a saved game?
 };
+
+// the level as it goes in a message after the board size, nothing for basic
+inline auto difficulty_word( int difficulty ) -> const char *
+{
+    static const char *words[NUMBER_OF_DIFFICULTIES] = { "", " advanced", " expert", " nightmare" };
+    return words[difficulty];
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+// a growable array that keeps up to Inline elements in place and only goes to the heap past that. made for plain
+// data like clues and clue sets: the elements are copied around as bytes and new ones start zeroed
+template<typename T, int Inline>
+class SmallVector
+{
+    static_assert( std::is_trivially_copyable<T>::value, "SmallVector copies its elements as plain data" );
+
+public:
+    SmallVector() : count( 0 ), local() { }
+    explicit SmallVector( int n ) : SmallVector() { resize( n ); }
+    template<typename It>
+    SmallVector( It first, It last ) : SmallVector()
+    {
+        for( ; first != last; ++first )
+        {
+            push_back( *first );
+        }
+    }
+
+    auto size() const -> int { return count; }
+    auto empty() const -> bool { return count == 0; }
+    auto data() -> T * { return count > Inline ? spill.data() : local; }
+    auto data() const -> const T * { return count > Inline ? spill.data() : local; }
+    auto operator[]( int i ) -> T & { return data()[i]; }
+    auto operator[]( int i ) const -> const T & { return data()[i]; }
+    auto begin() -> T * { return data(); }
+    auto end() -> T * { return data() + count; }
+    auto begin() const -> const T * { return data(); }
+    auto end() const -> const T * { return data() + count; }
+    auto back() -> T & { return data()[count - 1]; }
+
+    void clear() { resize( 0 ); }
+    void push_back( const T &value )
+    {
+        T copy = value; // value may live in this vector, and move when it grows
+        resize( count + 1 );
+        back() = copy;
+    }
+    void pop_back() { resize( count - 1 ); }
+
+    // elements past the old size are zeroed
+    void resize( int n )
+    {
+        if( n > Inline )
+        {
+            if( count <= Inline )
+            { // moving out: spill holds every element from now on
+                spill.assign( local, local + count );
+            }
+            spill.resize( n, T() );
+        }
+        else if( count > Inline )
+        { // moving back in
+            std::copy( spill.begin(), spill.begin() + n, local );
+            spill.clear();
+        }
+        else if( n > count )
+        {
+            std::fill( local + count, local + n, T() );
+        }
+        count = n;
+    }
+
+private:
+    int count;
+    T local[Inline];
+    std::vector<T> spill; // the elements, once there are more than Inline
+};
@@ -0,0 +1,177 @@
+// watson-check: check that puzzles have exactly one solution
+//
+// usage: watson-check [file]
+//
+// reads puzzles in the watson-gen format (from stdin without a file, lines starting with # are skipped) and counts
+// the solutions of each with a complete search, stopping at 2. every puzzle gets one line:
+//   seed unique|multiple|none solved|unsolved
+// the last field tells whether the deductions of the puzzle's level (check_clues) solve it.
+
+#include "game_data.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+// fill game_data from a watson-gen line, with the revealed blocks guessed. returns 0 on a malformed line
+static auto parse_puzzle( const std::string &line, uint64_t *seed, GameData *game_data ) -> int
+{
+    std::istringstream in( line );
+
+    if( !( in >> *seed >> game_data->number_of_columns >> game_data->column_height >> game_data->advanced ) )
+    {
+        return 0;
+    }
+    if( game_data->number_of_columns < 4 || game_data->number_of_columns > MAX_COLUMNS || game_data->column_height < 4
+        || game_data->column_height > MAX_ROWS || game_data->advanced < BASIC
+        || game_data->advanced >= NUMBER_OF_DIFFICULTIES )
+    {
+        return 0;
+    }
+
+    for( int row = 0; row < game_data->column_height; row++ )
+    {
+        for( int column = 0; column < game_data->number_of_columns; column++ )
+        {
+            int cell;
+            if( !( in >> cell ) || cell < 0 || cell >= game_data->number_of_columns )
+            {
+                return 0;
+            }
+            game_data->puzzle[column][row] = cell;
+        }
+    }
+
+    game_data->init_game();
+
+    int revealed_n;
+    if( !( in >> revealed_n ) )
+    {
+        return 0;
+    }
+    for( int i = 0; i < revealed_n; i++ )
+    {
+        int column;
+        int row;
+        if( !( in >> column >> row ) || column < 0 || column >= game_data->number_of_columns || row < 0
+            || row >= game_data->column_height )
+        {
+            return 0;
+        }
+        game_data->guess_tile( { column, row, game_data->puzzle[column][row] } );
+    }
+
+    int clue_n;
+    if( !( in >> clue_n ) || clue_n < 0 )
+    {
+        return 0;
+    }
+    game_data->clues.clear();
+    for( int i = 0; i < clue_n; i++ )
+    {
+        game_data->clues.push_back( {} );
+        auto &clue = game_data->clues.back();
+        int rel;
+        if( !( in >> rel ) || rel < 0 || rel >= NUMBER_OF_RELATIONS )
+        {
+            return 0;
+        }
+        clue.rel = (RELATION)rel;
+        clue.hidden = false;
+        for( auto &tile : clue.tile )
+        {
+            tile.valid = true;
+            if( !( in >> tile.column >> tile.row >> tile.cell ) || tile.column < 0
+                || tile.column >= game_data->number_of_columns || tile.row < 0 || tile.row >= game_data->column_height
+                || tile.cell < 0 || tile.cell >= game_data->number_of_columns )
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+auto main( int argc, char **argv ) -> int
+{
+    if( argc > 2 )
+    {
+        fprintf( stderr, "usage: watson-check [file]\n" );
+        return EXIT_FAILURE;
+    }
+
+    FILE *fp = argc == 2 ? fopen( argv[1], "r" ) : stdin;
+    if( !fp )
+    {
+        fprintf( stderr, "can't open %s\n", argv[1] );
+        return EXIT_FAILURE;
+    }
+
+    spdlog::set_level( spdlog::level::warn );
+    reset_rel_params();
+
+    int line_number = 0;
+    int puzzles = 0;
+    int counts[3] = {};
+    int unsolved = 0;
+    double seconds = 0;
+
+    auto *game_data = new GameData();
+    std::string line;
+    char buffer[4096];
+    while( fgets( buffer, sizeof( buffer ), fp ) )
+    {
+        line += buffer;
+        if( line.back() != '\n' && !feof( fp ) )
+        { // longer than the buffer
+            continue;
+        }
+        line_number++;
+
+        if( line[0] != '#' && line.find_first_not_of( " \t\r\n" ) != std::string::npos )
+        {
+            uint64_t seed;
+            if( !parse_puzzle( line, &seed, game_data ) )
+            {
+                fprintf( stderr, "malformed puzzle on line %d\n", line_number );
+                return EXIT_FAILURE;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            int count = game_data->count_solutions( 2 );
+            seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+            // count_solutions leaves the board as it was, so check_clues starts from the same one
+            game_data->check_clues();
+            int solved = game_data->guessed == game_data->number_of_columns * game_data->column_height;
+
+            const char *result[3] = { "none", "unique", "multiple" };
+            printf( "%llu %s %s\n", (unsigned long long)seed, result[count], solved ? "solved" : "unsolved" );
+            counts[count]++;
+            unsolved += !solved;
+            puzzles++;
+        }
+        line.clear();
+    }
+
+    if( fp != stdin )
+    {
+        fclose( fp );
+    }
+    delete game_data;
+
+    fprintf( stderr,
+             "%d puzzles: %d unique, %d multiple, %d none, %d unsolved by check_clues, %.3f ms per count\n",
+             puzzles,
+             counts[1],
+             counts[2],
+             counts[0],
+             unsolved,
+             puzzles ? 1000.0 * seconds / puzzles : 0.0 );
+
+    return counts[0] || counts[2] ? EXIT_FAILURE : EXIT_SUCCESS;
+}
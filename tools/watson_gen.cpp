@@ -0,0 +1,244 @@
+// watson-gen: generate batches of puzzles without the game
+//
+// usage: watson-gen [-n count] [-s COLUMNSxHEIGHT] [-a] [-l level] [-t threads] [-r seed] [-o file]
+//
+// puzzle i of a batch is generated from seed + i, so it can be reproduced on its own with -r
+// every puzzle is written as one line of space separated numbers:
+//   seed columns height advanced (0 basic, 1 advanced, 2 expert, 3 nightmare)
+//   solution cell of every block, row by row
+//   number of revealed blocks, then column row of each
+//   number of clues, then rel and column row cell of the three clue tiles for each
+
+#include "game_data.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+struct GenOptions
+{
+    int count = 100;
+    int number_of_columns = 6;
+    int column_height = 6;
+    int advanced = 0;
+    int threads = 0;
+    uint64_t seed = 0;
+    const char *output = "puzzles.txt";
+};
+
+static void usage()
+{
+    fprintf( stderr, "usage: watson-gen [-n count] [-s COLUMNSxHEIGHT] [-a] [-l level] [-t threads] [-r seed] [-o file]\n" );
+    fprintf( stderr, "  -n count   number of puzzles (default 100)\n" );
+    fprintf( stderr, "  -s CxH     board size, 4 to 16 (default 6x6)\n" );
+    fprintf( stderr, "  -a         advanced puzzles\n" );
+    fprintf( stderr, "  -l level   0 basic, 1 advanced, 2 expert, 3 nightmare\n" );
+    fprintf( stderr, "  -t threads worker threads (default: every core)\n" );
+    fprintf( stderr, "  -r seed    seed of the first puzzle (default: current time)\n" );
+    fprintf( stderr, "  -o file    output file (default puzzles.txt, - for stdout)\n" );
+}
+
+static auto parse_options( int argc, char **argv, GenOptions *options ) -> int
+{
+    for( int i = 1; i < argc; i++ )
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if( !strcmp( arg, "-a" ) )
+        {
+            options->advanced = 1;
+            continue;
+        }
+        if( !value )
+        {
+            return 0;
+        }
+
+        if( !strcmp( arg, "-n" ) )
+        {
+            options->count = atoi( value );
+        }
+        else if( !strcmp( arg, "-s" ) )
+        {
+            if( sscanf( value, "%dx%d", &options->number_of_columns, &options->column_height ) != 2 )
+            {
+                return 0;
+            }
+        }
+        else if( !strcmp( arg, "-l" ) )
+        {
+            options->advanced = atoi( value );
+        }
+        else if( !strcmp( arg, "-t" ) )
+        {
+            options->threads = atoi( value );
+        }
+        else if( !strcmp( arg, "-r" ) )
+        {
+            options->seed = strtoull( value, nullptr, 10 );
+        }
+        else if( !strcmp( arg, "-o" ) )
+        {
+            options->output = value;
+        }
+        else
+        {
+            return 0;
+        }
+        i++;
+    }
+
+    if( options->count < 0 || options->threads < 0 || options->advanced < BASIC
+        || options->advanced >= NUMBER_OF_DIFFICULTIES )
+    {
+        return 0;
+    }
+    if( options->number_of_columns < 4 || options->number_of_columns > MAX_COLUMNS || options->column_height < 4
+        || options->column_height > MAX_ROWS )
+    {
+        return 0;
+    }
+    return 1;
+}
+
+static const char *difficulty_name[NUMBER_OF_DIFFICULTIES] = { "basic", "advanced", "expert", "nightmare" };
+
+static auto format_puzzle( uint64_t seed, GameData *game_data ) -> std::string
+{
+    std::string line = std::to_string( seed ) + " " + std::to_string( game_data->number_of_columns ) + " "
+                       + std::to_string( game_data->column_height ) + " " + std::to_string( game_data->advanced );
+
+    for( int row = 0; row < game_data->column_height; row++ )
+    {
+        for( int column = 0; column < game_data->number_of_columns; column++ )
+        {
+            line += " " + std::to_string( game_data->puzzle[column][row] );
+        }
+    }
+
+    std::string revealed;
+    int revealed_n = 0;
+    for( int column = 0; column < game_data->number_of_columns; column++ )
+    {
+        for( int row = 0; row < game_data->column_height; row++ )
+        {
+            if( game_data->guess[column][row] >= 0 )
+            {
+                revealed += " " + std::to_string( column ) + " " + std::to_string( row );
+                revealed_n++;
+            }
+        }
+    }
+    line += " " + std::to_string( revealed_n ) + revealed;
+
+    line += " " + std::to_string( game_data->clues.size() );
+    for( int i = 0; i < game_data->clues.size(); i++ )
+    {
+        auto &clue = game_data->clues[i];
+        line += " " + std::to_string( clue.rel );
+        for( auto &tile : clue.tile )
+        {
+            line += " " + std::to_string( tile.column ) + " " + std::to_string( tile.row ) + " "
+                    + std::to_string( tile.cell );
+        }
+    }
+    return line + "\n";
+}
+
+auto main( int argc, char **argv ) -> int
+{
+    GenOptions options;
+    options.seed = (uint64_t)time( nullptr );
+    if( !parse_options( argc, argv, &options ) )
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    int threads = options.threads > 0 ? options.threads : std::max( 1u, std::thread::hardware_concurrency() );
+
+    FILE *fp = strcmp( options.output, "-" ) ? fopen( options.output, "w" ) : stdout;
+    if( !fp )
+    {
+        fprintf( stderr, "can't open %s\n", options.output );
+        return EXIT_FAILURE;
+    }
+    fprintf( fp,
+             "# watson-gen: seed columns height advanced, solution row by row, revealed blocks, "
+             "clues (rel and 3 tiles)\n" );
+
+    spdlog::set_level( spdlog::level::warn );
+    reset_rel_params();
+
+    std::atomic<int> next_puzzle( 0 );
+    std::mutex output_mutex;
+    std::map<int, int> clue_count; // clue_n -> puzzles
+
+    auto worker = [&]() {
+        GameData game_data = {};
+        game_data.number_of_columns = options.number_of_columns;
+        game_data.column_height = options.column_height;
+        game_data.advanced = options.advanced;
+        // the batch already keeps every core busy
+        game_data.threads = threads > 1 ? 1 : 0;
+
+        for( int i = next_puzzle++; i < options.count; i = next_puzzle++ )
+        {
+            game_data.rng.seed( options.seed + i );
+            game_data.create_game_with_clues();
+            std::string line = format_puzzle( options.seed + i, &game_data );
+
+            std::lock_guard<std::mutex> lock( output_mutex );
+            fputs( line.c_str(), fp );
+            clue_count[game_data.clues.size()]++;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    for( int i = 0; i < threads; i++ )
+    {
+        pool.emplace_back( worker );
+    }
+    for( auto &thread : pool )
+    {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    if( fp != stdout )
+    {
+        fclose( fp );
+    }
+
+    fprintf( stderr,
+             "%d %dx%d %s puzzles in %.2f s with %d threads: %.2f puzzles/s\n",
+             options.count,
+             options.number_of_columns,
+             options.column_height,
+             difficulty_name[options.advanced],
+             seconds,
+             threads,
+             seconds > 0 ? options.count / seconds : 0.0 );
+    fprintf( stderr, "clues  puzzles\n" );
+    for( auto &entry : clue_count )
+    {
+        fprintf( stderr, "%5d  %7d\n", entry.first, entry.second );
+    }
+
+    return EXIT_SUCCESS;
+}